@@ -0,0 +1,252 @@
+#include "plugin.hpp"
+#include <bit>
+#include "inc/cvRange.hpp"
+
+struct TapeBankModule : Module
+{
+   static const int CHANNELS = 8;
+
+   enum Params
+   {
+      ENUMS(PROBABILITY_PARAM, CHANNELS),
+      ENUMS(SHIFT_PARAM, CHANNELS),
+      LINK_PARAM,
+      DIR_PARAM,
+      NUM_PARAMS
+   };
+   enum Inputs
+   {
+      ENUMS(CLOCK_INPUT, CHANNELS),
+      NUM_INPUTS
+   };
+   enum Outputs
+   {
+      ENUMS(VOLTAGE_OUTPUT, CHANNELS),
+      ENUMS(GATE_OUTPUT, CHANNELS),
+      POLY_OUTPUT,
+      NUM_OUTPUTS
+   };
+   enum Lights
+   {
+      NUM_LIGHTS
+   };
+
+   // channel state in struct-of-arrays form, so each field is stepped four channels at a time
+   alignas(16) uint16_t tapes[CHANNELS] = {};
+   alignas(16) float probs[CHANNELS];
+   alignas(16) int shifts[CHANNELS];
+   alignas(16) float voltages[CHANNELS] = {};
+   alignas(16) float pulse_left[CHANNELS] = {};
+
+   dsp::TSchmittTrigger<simd::float_4> clocks[CHANNELS / 4];
+   dsp::SchmittTrigger linked_clock;
+
+   bool linked = true;
+   bool rtl = false;
+   CVRange voltage_range;
+
+   TapeBankModule()
+   {
+      config(Params::NUM_PARAMS, Inputs::NUM_INPUTS, Outputs::NUM_OUTPUTS, Lights::NUM_LIGHTS);
+      for (int c = 0; c < CHANNELS; c++)
+      {
+         std::string n = std::to_string(c + 1);
+         configParam(Params::PROBABILITY_PARAM + c, 0, 1, 0.5, "probability " + n, "%", 0, 100);
+         getParamQuantity(Params::PROBABILITY_PARAM + c)->description = "probability of a bit being toggled on each clock pulse.";
+         configParam(Params::SHIFT_PARAM + c, 1, 15, 1, "shift " + n, " bit(s)");
+         getParamQuantity(Params::SHIFT_PARAM + c)->description = "how many bits to shift with each clock pulse. (1-15 bits)";
+         getParamQuantity(Params::SHIFT_PARAM + c)->snapEnabled = true;
+         configInput(Inputs::CLOCK_INPUT + c, "clock " + n);
+         if (c > 0)
+         {
+            getInputInfo(Inputs::CLOCK_INPUT + c)->description = "normalled to the clock above. ignored while channels are linked.";
+         }
+         configOutput(Outputs::VOLTAGE_OUTPUT + c, "voltage " + n);
+         getOutputInfo(Outputs::VOLTAGE_OUTPUT + c)->description = "default range +/- 1V. adjust in context menu.";
+         configOutput(Outputs::GATE_OUTPUT + c, "gate " + n);
+         getOutputInfo(Outputs::GATE_OUTPUT + c)->description = "outputs a trigger on each clock pulse where the first bit (the one new values enter at) is set.";
+         probs[c] = 0.5f;
+         shifts[c] = 1;
+      }
+      configSwitch(Params::LINK_PARAM, 0, 1, 1, "link clocks", {"unlinked", "linked"});
+      getParamQuantity(Params::LINK_PARAM)->description = "when linked, clock 1 drives every channel with a single edge detector.";
+      configSwitch(Params::DIR_PARAM, 0, 1, 0, "direction", {"left-to-right", "right-to-left"});
+      getParamQuantity(Params::DIR_PARAM)->description = "direction to shift bits.";
+      configOutput(Outputs::POLY_OUTPUT, "polyphonic voltage");
+      getOutputInfo(Outputs::POLY_OUTPUT)->description = "all eight voltages as one polyphonic signal.";
+   }
+
+   void onReset() override
+   {
+      for (int c = 0; c < CHANNELS; c++)
+      {
+         tapes[c] = 0;
+         pulse_left[c] = 0.f;
+      }
+      voltage_range.cv_a = -1;
+      voltage_range.cv_b = 1;
+      voltage_range.updateInternal();
+      updateVoltages();
+   }
+
+   json_t *dataToJson() override
+   {
+      json_t *rootJ = json_object();
+      json_object_set_new(rootJ, "voltage_range", voltage_range.dataToJson());
+      return rootJ;
+   }
+
+   void dataFromJson(json_t *rootJ) override
+   {
+      json_t *vRangeJ = json_object_get(rootJ, "voltage_range");
+      if (vRangeJ)
+      {
+         voltage_range.dataFromJson(vRangeJ);
+      }
+   }
+
+   const int PARAM_INTERVAL = 64;
+   int check_params = 0;
+   void processParams()
+   {
+      for (int c = 0; c < CHANNELS; c++)
+      {
+         probs[c] = params[PROBABILITY_PARAM + c].getValue();
+         shifts[c] = params[SHIFT_PARAM + c].getValue();
+      }
+      linked = params[LINK_PARAM].getValue();
+      rtl = params[DIR_PARAM].getValue();
+      updateVoltages();
+   }
+
+   void updateVoltages()
+   {
+      simd::float_4 scale = voltage_range.range / 65535.f;
+      simd::float_4 offset = voltage_range.min;
+      for (int c = 0; c < CHANNELS; c += 4)
+      {
+         simd::float_4 tape(tapes[c], tapes[c + 1], tapes[c + 2], tapes[c + 3]);
+         (tape * scale + offset).store(&voltages[c]);
+      }
+   }
+
+   // steps every channel whose bit is set in `edges` (bit c = channel c)
+   void step(int edges)
+   {
+      int flips = 0;
+      for (int c = 0; c < CHANNELS; c += 4)
+      {
+         simd::float_4 noise(random::uniform(), random::uniform(), random::uniform(), random::uniform());
+         flips |= simd::movemask(noise >= simd::float_4::load(&probs[c])) << c;
+      }
+
+      uint16_t head = rtl ? 0x0001 : 0x8000;
+      for (int c = 0; c < CHANNELS; c++)
+      {
+         bool edge = (edges >> c) & 1;
+         uint16_t stepped = rtl ? std::rotl(tapes[c], shifts[c]) : std::rotr(tapes[c], shifts[c]);
+         stepped ^= ((flips >> c) & 1) ? head : 0;
+         tapes[c] = edge ? stepped : tapes[c];
+         pulse_left[c] = (edge && (tapes[c] & head)) ? 0.01f : pulse_left[c];
+      }
+      updateVoltages();
+   }
+
+   void process(const ProcessArgs &args) override
+   {
+      if (++check_params > PARAM_INTERVAL)
+      {
+         check_params = 0;
+         processParams();
+      }
+
+      int edges = 0;
+      if (linked)
+      {
+         edges = linked_clock.process(inputs[CLOCK_INPUT].getVoltage()) ? (1 << CHANNELS) - 1 : 0;
+      }
+      else
+      {
+         alignas(16) float clock_inputs[CHANNELS];
+         float v = 0.f;
+         for (int c = 0; c < CHANNELS; c++)
+         {
+            v = inputs[CLOCK_INPUT + c].getNormalVoltage(v);
+            clock_inputs[c] = v;
+         }
+         for (int c = 0; c < CHANNELS; c += 4)
+         {
+            edges |= simd::movemask(clocks[c / 4].process(simd::float_4::load(&clock_inputs[c]))) << c;
+         }
+      }
+
+      if (edges)
+      {
+         step(edges);
+      }
+
+      outputs[POLY_OUTPUT].setChannels(CHANNELS);
+      for (int c = 0; c < CHANNELS; c += 4)
+      {
+         simd::float_4 left = simd::float_4::load(&pulse_left[c]) - args.sampleTime;
+         left.store(&pulse_left[c]);
+         simd::float_4 gates = simd::ifelse(left > 0.f, 10.f, 0.f);
+         simd::float_4 volts = simd::float_4::load(&voltages[c]);
+         outputs[POLY_OUTPUT].setVoltageSimd(volts, c);
+         for (int i = 0; i < 4; i++)
+         {
+            outputs[VOLTAGE_OUTPUT + c + i].setVoltage(volts[i]);
+            outputs[GATE_OUTPUT + c + i].setVoltage(gates[i]);
+         }
+      }
+   }
+};
+
+struct TapeBankModuleWidget : ModuleWidget
+{
+   TapeBankModuleWidget(TapeBankModule *module)
+   {
+      setModule(module);
+      setPanel(createPanel(asset::plugin(pluginInstance, "res/tape-bank.svg")));
+
+      float dx = RACK_GRID_WIDTH;
+      float dy = RACK_GRID_WIDTH;
+      float x_start = dx * 1.5;
+      float y_start = dy * 4.5;
+      float x = x_start;
+      float y = y_start;
+
+      addParam(createParamCentered<CKSS>(Vec(x, y), module, TapeBankModule::LINK_PARAM));
+      x += dx * 2;
+      addParam(createParamCentered<CKSS>(Vec(x, y), module, TapeBankModule::DIR_PARAM));
+      x += dx * 6.5;
+      addOutput(createOutputCentered<BitPort>(Vec(x, y), module, TapeBankModule::POLY_OUTPUT));
+      y += dy * 2.5;
+
+      for (int c = 0; c < TapeBankModule::CHANNELS; c++)
+      {
+         x = x_start;
+         addInput(createInputCentered<BitPort>(Vec(x, y), module, TapeBankModule::CLOCK_INPUT + c));
+         x += dx * 2;
+         addParam(createParamCentered<SmallBitKnob>(Vec(x, y), module, TapeBankModule::PROBABILITY_PARAM + c));
+         x += dx * 2;
+         addParam(createParamCentered<SmallBitKnob>(Vec(x, y), module, TapeBankModule::SHIFT_PARAM + c));
+         x += dx * 2.5;
+         addOutput(createOutputCentered<BitPort>(Vec(x, y), module, TapeBankModule::VOLTAGE_OUTPUT + c));
+         x += dx * 2;
+         addOutput(createOutputCentered<BitPort>(Vec(x, y), module, TapeBankModule::GATE_OUTPUT + c));
+         y += dy * 2.2;
+      }
+   }
+
+   void appendContextMenu(Menu *menu) override
+   {
+      TapeBankModule *module = dynamic_cast<TapeBankModule *>(this->module);
+      assert(module);
+
+      menu->addChild(new MenuSeparator());
+      module->voltage_range.addMenu(module, menu, "voltage range");
+   }
+};
+
+Model *modelTapeBank = createModel<TapeBankModule, TapeBankModuleWidget>("tape-bank");
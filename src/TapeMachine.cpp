@@ -3,6 +3,31 @@
 #include <random>
 #include <ctime>
 #include "inc/cvRange.hpp"
+#include "inc/tapePlayer.hpp"
+#include "inc/clockGen.hpp"
+#include "inc/tapeStats.hpp"
+#include "inc/bitLogic.hpp"
+#include "inc/weightedDac.hpp"
+#include "inc/writeWindow.hpp"
+#include "inc/tapeGroup.hpp"
+#include "inc/tapeMorph.hpp"
+#include "inc/patternLibrary.hpp"
+#include "inc/tripleBuffer.hpp"
+#include "inc/profiler.hpp"
+#include <atomic>
+#include <osdialog.h>
+
+// shows the pattern the selector points at, in the bank chosen in the context menu
+struct PatternQuantity : ParamQuantity
+{
+   size_t *bank = nullptr;
+
+   std::string getDisplayValueString() override
+   {
+      int b = bank ? (int)*bank : (int)PatternLibrary::EUCLIDEAN;
+      return PatternLibrary::name(b, PatternLibrary::index(b, getValue()));
+   }
+};
 
 struct TapeMachineModule : Module
 {
@@ -13,6 +38,16 @@ struct TapeMachineModule : Module
       SET_PARAM,
       SHIFT_PARAM,
       DIR_PARAM,
+      BPM_PARAM,
+      RATIO_PARAM,
+      WRITE_PARAM,
+      PROB_CV_PARAM,
+      WINDOW_WIDTH_PARAM,
+      WINDOW_POS_PARAM,
+      MORPH_PARAM,
+      MORPH_SNAP_PARAM,
+      PATTERN_PARAM,
+      PATTERN_LOAD_PARAM,
       NUM_PARAMS
    };
    enum Inputs
@@ -22,6 +57,16 @@ struct TapeMachineModule : Module
       SET_INPUT,
       SHIFT_INPUT,
       DIR_INPUT,
+      SCRUB_INPUT,
+      RATIO_INPUT,
+      WRITE_INPUT,
+      WRITE_GATE_INPUT,
+      PROB_INPUT,
+      WINDOW_WIDTH_INPUT,
+      WINDOW_POS_INPUT,
+      MORPH_INPUT,
+      PATTERN_INPUT,
+      PATTERN_LOAD_INPUT,
       NUM_INPUTS
    };
    enum Outputs
@@ -32,6 +77,13 @@ struct TapeMachineModule : Module
       MIN_OUTPUT,
       MAX_OUTPUT,
       RANDOM_PULSE_OUTPUT,
+      CLOCK_OUTPUT,
+      DENSITY_OUTPUT,
+      RUN_OUTPUT,
+      TRANSITIONS_OUTPUT,
+      ENTROPY_OUTPUT,
+      ENUMS(LOGIC_OUTPUT, 4),
+      ENUMS(DAC_OUTPUT, 4),
       NUM_OUTPUTS
    };
    enum Lights
@@ -39,10 +91,13 @@ struct TapeMachineModule : Module
       ENUMS(BIT_LIGHT, 16),
       CLEAR_LIGHT,
       SET_LIGHT,
+      WRITE_LIGHT,
       NUM_LIGHTS
    };
 
    uint16_t tape = 0b0;
+   // what the outputs read: the tape morphed toward morph_target, updated once per clock
+   uint16_t out_tape = 0b0;
    bool bit_toggled = false;
    dsp::PulseGenerator random_pulse;
    uint16_t masks[16] = {
@@ -66,14 +121,63 @@ struct TapeMachineModule : Module
    float noise = 0.f;
    bool clear = false;
    bool set = false;
+   bool write_gray = false;
    int shift_amt = 1;
    CVRange voltage_range;
    CVRange flipped_voltage_range;
    CVRange min_voltage_range;
    CVRange max_voltage_range;
+   CVRange dac_ranges[WeightedDac::TAPS];
+
+   WeightedDac dac;
 
    dsp::SchmittTrigger clock;
    dsp::SchmittTrigger dir_trigger;
+   // a direction edge seen since the last clock, waiting for it when direction is sampled on clock
+   bool dir_pending = false;
+
+   TapeStats stats;
+
+   // user-defined logic outputs. each expression is compiled on the UI thread and handed to
+   // process() through a triple buffer, so edits never touch the program being evaluated.
+   static const int LOGIC_COUNT = 4;
+   std::string logic_exprs[LOGIC_COUNT];
+   bool logic_valid[LOGIC_COUNT] = {true, true, true, true};
+   TripleBuffer<BitLogic::Program> logic_programs[LOGIC_COUNT];
+   bool logic_state[LOGIC_COUNT] = {};
+   dsp::PulseGenerator logic_pulses[LOGIC_COUNT];
+
+#ifdef TURINGSBITS_PROFILE
+   ProcessProfiler profiler;
+#endif
+
+   // TapeGroup index, -1 for none. owned by the ui thread.
+   int group = -1;
+   // group * TapeGroup::MEMBERS + member index, -1 for none, so the audio thread reads both at once. the lowest member leads.
+   std::atomic<int> group_slot{-1};
+   // whether the last sample took its clock from the group, so falling back to the own clock starts from fresh trigger state
+   bool group_followed = false;
+   // correlated members all flip on the group's first random word, decorrelated ones on their own
+   bool group_correlated = false;
+
+   // morph target is the stored snapshot, or the group leader's tape after the edge being followed (read from the group slot)
+   size_t morph_source = 0;
+   uint16_t morph_snapshot = 0;
+   uint16_t morph_target = 0;
+   float morph_amount = 0.f;
+   uint16_t group_tape = 0;
+   bool group_tape_valid = false;
+   dsp::BooleanTrigger morph_snap_trigger;
+
+   // a load trigger arms the selected pattern, which replaces the tape on the next clock
+   size_t pattern_bank = PatternLibrary::EUCLIDEAN;
+   bool pattern_armed = false;
+   dsp::SchmittTrigger pattern_load_trigger;
+   dsp::BooleanTrigger pattern_button_trigger;
+
+   ClockGen clock_gen;
+   size_t clock_mode = ClockGen::EXTERNAL;
+   std::vector<std::string> clock_mode_labels = {"external", "internal", "pll"};
 
    size_t bit_pulse_mode = 1;
    size_t random_pulse_mode = 1;
@@ -83,23 +187,41 @@ struct TapeMachineModule : Module
 
    bool rtl = false;
 
+   // control inputs that can be sampled once per clock (held until the next one) instead of every sample
+   enum SampledInput
+   {
+      SAMPLE_SHIFT,
+      SAMPLE_DIR,
+      SAMPLE_SET,
+      SAMPLE_CLEAR,
+      SAMPLE_PROB,
+      NUM_SAMPLED
+   };
+   bool sample_on_clock[NUM_SAMPLED] = {};
+   std::vector<std::string> sampled_labels = {"shift", "direction", "set", "clear", "probability"};
+
+   TapePlayer player;
+   bool playback = false;
+   bool playback_loop = true;
+   size_t play_pos = 0;
+
    TapeMachineModule()
    {
       config(Params::NUM_PARAMS, Inputs::NUM_INPUTS, Outputs::NUM_OUTPUTS, Lights::NUM_LIGHTS);
       configParam(Params::PROBABILITY_PARAM, 0, 1, 0.5, "probability", "%", 0, 100);
       getParamQuantity(Params::PROBABILITY_PARAM)->description = "probability of a bit being toggled on each clock pulse.";
       configParam(Params::CLEAR_PARAM, 0, 1, 0, "clear");
-      getParamQuantity(Params::CLEAR_PARAM)->description = "clears first bit on each clock pulse while held.";
+      getParamQuantity(Params::CLEAR_PARAM)->description = "clears the write window (first bit by default) on each clock pulse while held.";
       configParam(Params::SET_PARAM, 0, 1, 0, "set");
-      getParamQuantity(Params::SET_PARAM)->description = "sets first bit on each clock pulse while held.";
+      getParamQuantity(Params::SET_PARAM)->description = "sets the write window (first bit by default) on each clock pulse while held.";
       configParam(Params::SHIFT_PARAM, 1, 15, 1, "shift", " bit(s)");
       getParamQuantity(Params::SHIFT_PARAM)->description = "how many bits to shift with each clock pulse. (1-15 bits)";
       getParamQuantity(Params::SHIFT_PARAM)->snapEnabled = true;
       configInput(Inputs::CLOCK_INPUT, "clock");
       configInput(Inputs::CLEAR_INPUT, "clear");
-      getInputInfo(Inputs::CLEAR_INPUT)->description = "clears first bit on each clock pulse while input gate is high. expects 0-10V.";
+      getInputInfo(Inputs::CLEAR_INPUT)->description = "clears the write window on each clock pulse while input gate is high. expects 0-10V.";
       configInput(Inputs::SET_INPUT, "set");
-      getInputInfo(Inputs::SET_INPUT)->description = "sets first bit on each clock pulse while input gate is high. expects 0-10V.";
+      getInputInfo(Inputs::SET_INPUT)->description = "sets the write window on each clock pulse while input gate is high. expects 0-10V.";
       configInput(Inputs::SHIFT_INPUT, "shift");
       getInputInfo(Inputs::SHIFT_INPUT)->description = "how many bits to shift with each clock pulse. expects 0-10V (1-15 bits).";
       configOutput(Outputs::VOLTAGE_OUTPUT, "voltage");
@@ -116,6 +238,68 @@ struct TapeMachineModule : Module
       getParamQuantity(Params::DIR_PARAM)->description = "direction to shift bits.";
       configInput(Inputs::DIR_INPUT, "direction");
       getInputInfo(Inputs::DIR_INPUT)->description = "toggle direction to shift bits between left-to-right and right-to-left. expects 0-10V gate signal.";
+      configInput(Inputs::SCRUB_INPUT, "scrub");
+      getInputInfo(Inputs::SCRUB_INPUT)->description = "jumps to a position in the tape file on each clock pulse during playback. expects 0-10V (start to end of file).";
+      configParam(Params::WRITE_PARAM, 0, 1, 0, "write");
+      getParamQuantity(Params::WRITE_PARAM)->description = "replaces the tape with the sampled write input on each clock pulse while held.";
+      configInput(Inputs::WRITE_GATE_INPUT, "write gate");
+      getInputInfo(Inputs::WRITE_GATE_INPUT)->description = "replaces the tape with the sampled write input on each clock pulse while input gate is high. expects 0-10V.";
+      configInput(Inputs::WRITE_INPUT, "write");
+      getInputInfo(Inputs::WRITE_INPUT)->description = "voltage sampled into the tape on write, through the inverse of the voltage range (binary or gray code set in context menu).";
+      configParam(Params::PROB_CV_PARAM, -1, 1, 0, "probability cv", "%", 0, 100);
+      getParamQuantity(Params::PROB_CV_PARAM)->description = "attenuverter for the probability input.";
+      configInput(Inputs::PROB_INPUT, "probability");
+      getInputInfo(Inputs::PROB_INPUT)->description = "added to the probability param through the attenuverter. 10V = 100%.";
+      configParam(Params::WINDOW_WIDTH_PARAM, 1, 16, 1, "write window width", " bit(s)");
+      getParamQuantity(Params::WINDOW_WIDTH_PARAM)->description = "how many bits set and clear write to on each clock pulse. (1-16 bits)";
+      getParamQuantity(Params::WINDOW_WIDTH_PARAM)->snapEnabled = true;
+      configParam(Params::WINDOW_POS_PARAM, 0, 15, 0, "write window position", " bit(s)");
+      getParamQuantity(Params::WINDOW_POS_PARAM)->description = "how far from the first bit the set/clear window starts. (0-15 bits)";
+      getParamQuantity(Params::WINDOW_POS_PARAM)->snapEnabled = true;
+      configInput(Inputs::WINDOW_WIDTH_INPUT, "write window width");
+      getInputInfo(Inputs::WINDOW_WIDTH_INPUT)->description = "added to the write window width. expects 0-10V (0-16 bits).";
+      configInput(Inputs::WINDOW_POS_INPUT, "write window position");
+      getInputInfo(Inputs::WINDOW_POS_INPUT)->description = "added to the write window position, wrapping around the tape. expects 0-10V (0-16 bits).";
+      configParam(Params::MORPH_PARAM, 0, 1, 0, "morph", "%", 0, 100);
+      getParamQuantity(Params::MORPH_PARAM)->description = "how far the outputs move from the tape toward the morph target, flipping the differing bits lowest first. applied on each clock pulse.";
+      configInput(Inputs::MORPH_INPUT, "morph");
+      getInputInfo(Inputs::MORPH_INPUT)->description = "added to the morph knob. 10V = 100%.";
+      configParam(Params::MORPH_SNAP_PARAM, 0, 1, 0, "store morph snapshot");
+      getParamQuantity(Params::MORPH_SNAP_PARAM)->description = "stores the current tape as the morph target (snapshot target set in context menu).";
+      configParam<PatternQuantity>(Params::PATTERN_PARAM, 0, 1, 0, "pattern")->bank = &pattern_bank;
+      getParamQuantity(Params::PATTERN_PARAM)->description = "pattern loaded into the tape, from the bank set in context menu.";
+      configInput(Inputs::PATTERN_INPUT, "pattern");
+      getInputInfo(Inputs::PATTERN_INPUT)->description = "added to the pattern selector. 0-10V spans the bank.";
+      configParam(Params::PATTERN_LOAD_PARAM, 0, 1, 0, "load pattern");
+      getParamQuantity(Params::PATTERN_LOAD_PARAM)->description = "loads the selected pattern into the tape on the next clock pulse.";
+      configInput(Inputs::PATTERN_LOAD_INPUT, "load pattern");
+      getInputInfo(Inputs::PATTERN_LOAD_INPUT)->description = "loads the selected pattern into the tape on the next clock pulse. expects a 0-10V trigger.";
+      configParam(Params::BPM_PARAM, 30, 300, 120, "bpm", " bpm");
+      getParamQuantity(Params::BPM_PARAM)->description = "tempo of the internal clock (clock source set in context menu).";
+      configSwitch(Params::RATIO_PARAM, 0, ClockGen::RATIO_COUNT - 1, ClockGen::RATIO_DEFAULT, "clock ratio", ClockGen::ratioLabels());
+      getParamQuantity(Params::RATIO_PARAM)->description = "multiplies or divides the internal and pll clock.";
+      configInput(Inputs::RATIO_INPUT, "clock ratio");
+      getInputInfo(Inputs::RATIO_INPUT)->description = "offsets the clock ratio by one step per volt. expects +/-5V.";
+      configOutput(Outputs::CLOCK_OUTPUT, "clock");
+      getOutputInfo(Outputs::CLOCK_OUTPUT)->description = "the clock driving the tape (external, internal or pll).";
+      configOutput(Outputs::DENSITY_OUTPUT, "density");
+      getOutputInfo(Outputs::DENSITY_OUTPUT)->description = "number of set bits. 0-10V (0-16 bits).";
+      configOutput(Outputs::RUN_OUTPUT, "longest run");
+      getOutputInfo(Outputs::RUN_OUTPUT)->description = "longest run of consecutive set bits around the tape. 0-10V (0-16 bits).";
+      configOutput(Outputs::TRANSITIONS_OUTPUT, "transitions");
+      getOutputInfo(Outputs::TRANSITIONS_OUTPUT)->description = "number of changes between set and clear bits around the tape. 0-10V (0-16).";
+      configOutput(Outputs::ENTROPY_OUTPUT, "entropy");
+      getOutputInfo(Outputs::ENTROPY_OUTPUT)->description = "shannon entropy of the bits over the last " + std::to_string(TapeStats::HISTORY) + " clock pulses. 0-10V (0-1 bit).";
+      for (int i = 0; i < LOGIC_COUNT; i++)
+      {
+         configOutput(Outputs::LOGIC_OUTPUT + i, "logic " + std::to_string(i + 1));
+         getOutputInfo(Outputs::LOGIC_OUTPUT + i)->description = "outputs pulse signal (bit pulse mode) while its logic expression (set in context menu) is true.";
+      }
+      for (int i = 0; i < WeightedDac::TAPS; i++)
+      {
+         configOutput(Outputs::DAC_OUTPUT + i, "dac " + std::to_string(i + 1));
+         getOutputInfo(Outputs::DAC_OUTPUT + i)->description = "weighted sum of the bits (weights set in context menu). default range +/- 1V. adjust in context menu.";
+      }
       for (int i = 0; i < 16; i++)
       {
          configOutput(Outputs::PULSE_OUTPUT + i, "bit 2^" + std::to_string(i));
@@ -124,11 +308,38 @@ struct TapeMachineModule : Module
       }
    }
 
+   ~TapeMachineModule()
+   {
+      setGroup(-1);
+   }
+
    void onReset() override
    {
       tape = 0b0;
+      out_tape = 0b0;
+      morph_source = 0;
+      morph_snapshot = 0;
+      pattern_bank = PatternLibrary::EUCLIDEAN;
+      pattern_armed = false;
       bit_pulse_mode = 1;
       random_pulse_mode = 1;
+      write_gray = false;
+      for (int i = 0; i < NUM_SAMPLED; i++)
+      {
+         sample_on_clock[i] = false;
+      }
+      dir_pending = false;
+      playback = false;
+      playback_loop = true;
+      play_pos = 0;
+      clock_mode = ClockGen::EXTERNAL;
+      clock_gen.reset();
+      stats.reset();
+      for (int i = 0; i < LOGIC_COUNT; i++)
+      {
+         setLogicExpression(i, "");
+         logic_pulses[i].reset();
+      }
 
       voltage_range.cv_a = -1;
       voltage_range.cv_b = 1;
@@ -146,6 +357,14 @@ struct TapeMachineModule : Module
       max_voltage_range.cv_b = 1;
       max_voltage_range.updateInternal();
 
+      dac.reset();
+      for (int i = 0; i < WeightedDac::TAPS; i++)
+      {
+         dac_ranges[i].cv_a = -1;
+         dac_ranges[i].cv_b = 1;
+         dac_ranges[i].updateInternal();
+      }
+
       for (int i = 0; i < 16; i++)
       {
          bit_pulses[i].reset();
@@ -162,6 +381,35 @@ struct TapeMachineModule : Module
       json_object_set_new(rootJ, "flipped_voltage_range", flipped_voltage_range.dataToJson());
       json_object_set_new(rootJ, "min_voltage_range", min_voltage_range.dataToJson());
       json_object_set_new(rootJ, "max_voltage_range", max_voltage_range.dataToJson());
+      json_object_set_new(rootJ, "clock_mode", json_integer(clock_mode));
+      json_object_set_new(rootJ, "group", json_integer(group));
+      json_object_set_new(rootJ, "group_correlated", json_boolean(group_correlated));
+      json_object_set_new(rootJ, "morph_source", json_integer(morph_source));
+      json_object_set_new(rootJ, "morph_snapshot", json_integer(morph_snapshot));
+      json_object_set_new(rootJ, "pattern_bank", json_integer(pattern_bank));
+      json_object_set_new(rootJ, "write_gray", json_boolean(write_gray));
+      json_t *sampleJ = json_array();
+      for (int i = 0; i < NUM_SAMPLED; i++)
+      {
+         json_array_append_new(sampleJ, json_boolean(sample_on_clock[i]));
+      }
+      json_object_set_new(rootJ, "sample_on_clock", sampleJ);
+      json_object_set_new(rootJ, "dac_weights", dac.dataToJson());
+      json_t *dacRangesJ = json_array();
+      for (int i = 0; i < WeightedDac::TAPS; i++)
+      {
+         json_array_append_new(dacRangesJ, dac_ranges[i].dataToJson());
+      }
+      json_object_set_new(rootJ, "dac_ranges", dacRangesJ);
+      json_t *logicJ = json_array();
+      for (int i = 0; i < LOGIC_COUNT; i++)
+      {
+         json_array_append_new(logicJ, json_string(logic_exprs[i].c_str()));
+      }
+      json_object_set_new(rootJ, "logic_expressions", logicJ);
+      json_object_set_new(rootJ, "tape_file", json_string(player.path().c_str()));
+      json_object_set_new(rootJ, "playback", json_boolean(playback));
+      json_object_set_new(rootJ, "playback_loop", json_boolean(playback_loop));
       return rootJ;
    }
 
@@ -197,6 +445,86 @@ struct TapeMachineModule : Module
       {
          max_voltage_range.dataFromJson(maxRangeJ);
       }
+      json_t *writeGrayJ = json_object_get(rootJ, "write_gray");
+      if (writeGrayJ)
+      {
+         write_gray = json_boolean_value(writeGrayJ);
+      }
+      json_t *sampleJ = json_object_get(rootJ, "sample_on_clock");
+      if (sampleJ)
+      {
+         for (int i = 0; i < NUM_SAMPLED && i < (int)json_array_size(sampleJ); i++)
+         {
+            sample_on_clock[i] = json_boolean_value(json_array_get(sampleJ, i));
+         }
+      }
+      json_t *clockModeJ = json_object_get(rootJ, "clock_mode");
+      if (clockModeJ)
+      {
+         clock_mode = json_integer_value(clockModeJ);
+      }
+      json_t *groupJ = json_object_get(rootJ, "group");
+      if (groupJ)
+      {
+         setGroup(json_integer_value(groupJ));
+      }
+      json_t *groupCorrelatedJ = json_object_get(rootJ, "group_correlated");
+      if (groupCorrelatedJ)
+      {
+         group_correlated = json_boolean_value(groupCorrelatedJ);
+      }
+      json_t *morphSourceJ = json_object_get(rootJ, "morph_source");
+      if (morphSourceJ)
+      {
+         morph_source = json_integer_value(morphSourceJ);
+      }
+      json_t *morphSnapshotJ = json_object_get(rootJ, "morph_snapshot");
+      if (morphSnapshotJ)
+      {
+         morph_snapshot = json_integer_value(morphSnapshotJ);
+      }
+      json_t *patternBankJ = json_object_get(rootJ, "pattern_bank");
+      if (patternBankJ)
+      {
+         pattern_bank = clamp((int)json_integer_value(patternBankJ), 0, PatternLibrary::NUM_BANKS - 1);
+      }
+      json_t *dacWeightsJ = json_object_get(rootJ, "dac_weights");
+      if (dacWeightsJ)
+      {
+         dac.dataFromJson(dacWeightsJ);
+      }
+      json_t *dacRangesJ = json_object_get(rootJ, "dac_ranges");
+      if (dacRangesJ)
+      {
+         for (int i = 0; i < WeightedDac::TAPS && i < (int)json_array_size(dacRangesJ); i++)
+         {
+            dac_ranges[i].dataFromJson(json_array_get(dacRangesJ, i));
+         }
+      }
+      json_t *logicJ = json_object_get(rootJ, "logic_expressions");
+      if (logicJ)
+      {
+         for (int i = 0; i < LOGIC_COUNT && i < (int)json_array_size(logicJ); i++)
+         {
+            const char *expr = json_string_value(json_array_get(logicJ, i));
+            setLogicExpression(i, expr ? expr : "");
+         }
+      }
+      json_t *tapeFileJ = json_object_get(rootJ, "tape_file");
+      if (tapeFileJ && json_string_value(tapeFileJ)[0])
+      {
+         loadTapeFile(json_string_value(tapeFileJ));
+      }
+      json_t *playbackJ = json_object_get(rootJ, "playback");
+      if (playbackJ)
+      {
+         playback = json_boolean_value(playbackJ);
+      }
+      json_t *playbackLoopJ = json_object_get(rootJ, "playback_loop");
+      if (playbackLoopJ)
+      {
+         playback_loop = json_boolean_value(playbackLoopJ);
+      }
    }
 
    size_t getBitMode()
@@ -219,62 +547,278 @@ struct TapeMachineModule : Module
       random_pulse_mode = mode;
    }
 
+   size_t getClockMode()
+   {
+      return clock_mode;
+   }
+
+   void setClockMode(size_t mode)
+   {
+      clock_mode = mode;
+      clock_gen.reset();
+   }
+
+   // compiles on the calling (UI) thread; process() picks the program up on its next clock.
+   void setLogicExpression(int index, const std::string &expr)
+   {
+      logic_exprs[index] = expr;
+      logic_valid[index] = BitLogic::compile(expr, logic_programs[index].writeSlot());
+      logic_programs[index].publish();
+   }
+
+   void loadTapeFile(const std::string &path)
+   {
+      if (player.open(path))
+      {
+         play_pos = 0;
+      }
+   }
+
+   void ejectTapeFile()
+   {
+      player.close();
+      play_pos = 0;
+   }
+
+   // whether the write button or gate is held
+   bool writeGate()
+   {
+      return params[WRITE_PARAM].getValue() > 0.f || inputs[WRITE_GATE_INPUT].getVoltage() > 5.f;
+   }
+
+   // converts the write input to a tape value through the inverse of voltage_range, so a
+   // written tape plays back the sampled voltage on the voltage output
+   uint16_t sampleWriteInput()
+   {
+      float x = voltage_range.range > 0.f ? voltage_range.invMap(inputs[WRITE_INPUT].getVoltage()) : 0.f;
+      uint16_t value = (uint16_t)std::round(clamp(x, 0.f, 1.f) * 65535.f);
+      return write_gray ? value ^ (value >> 1) : value;
+   }
+
+   // leaves the current group and joins `g` (-1 for none). stays out of any group if `g` is full.
+   void setGroup(int g)
+   {
+      int slot = group_slot.exchange(-1);
+      if (slot >= 0)
+      {
+         TapeGroup::get(slot / TapeGroup::MEMBERS).leave(slot % TapeGroup::MEMBERS);
+      }
+      group = -1;
+      if (g >= 0 && g < TapeGroup::GROUPS)
+      {
+         int member = TapeGroup::get(g).join();
+         if (member >= 0)
+         {
+            group = g;
+            group_slot = g * TapeGroup::MEMBERS + member;
+         }
+      }
+   }
+
+   bool hasClockSource()
+   {
+      return inputs[CLOCK_INPUT].isConnected() || clock_mode != ClockGen::EXTERNAL;
+   }
+
+   // replaces the clock with the group's, as published by the leader on the frame before, and
+   // picks up the tape the leader stepped to on that frame.
+   // returns false, leaving the clock alone, when no leader published that frame, or when the
+   // leader has no clock source and this member has one.
+   bool followGroup(int slot, int64_t frame, bool &new_clock, float &clock_input)
+   {
+      uint32_t word = 0;
+      bool clocked = false;
+      bool edge = false;
+      float gate = 0.f;
+      int index = group_correlated ? 0 : slot % TapeGroup::MEMBERS;
+      if (!TapeGroup::get(slot / TapeGroup::MEMBERS).read(frame - 1, index, edge, gate, clocked, word, group_tape))
+      {
+         return false;
+      }
+      if (!clocked && hasClockSource())
+      {
+         return false;
+      }
+      new_clock = edge;
+      clock_input = gate;
+      group_tape_valid = true;
+      if (new_clock)
+      {
+         noise = word * (1.f / 4294967296.f);
+      }
+      return true;
+   }
+
+   // reads the pattern selector and cv, only on clocks that load a pattern
+   uint16_t selectedPattern()
+   {
+      float position = params[PATTERN_PARAM].getValue();
+      if (inputs[PATTERN_INPUT].isConnected())
+      {
+         position += inputs[PATTERN_INPUT].getVoltage() / 10.f;
+      }
+      return PatternLibrary::get(pattern_bank, PatternLibrary::index(pattern_bank, position));
+   }
+
+   // reads the morph knob and cv, only on clocks
+   uint16_t morphView()
+   {
+      morph_amount = params[MORPH_PARAM].getValue();
+      if (inputs[MORPH_INPUT].isConnected())
+      {
+         morph_amount += inputs[MORPH_INPUT].getVoltage() / 10.f;
+      }
+      morph_amount = clamp(morph_amount, 0.f, 1.f);
+      morph_target = (morph_source == 1 && group_tape_valid) ? group_tape : morph_snapshot;
+      return TapeMorph<uint16_t>::view(tape, morph_target, morph_amount);
+   }
+
+   // reads the write window params and cv, only on clocks that set or clear
+   uint16_t windowMask()
+   {
+      int window_width = params[WINDOW_WIDTH_PARAM].getValue();
+      int window_pos = params[WINDOW_POS_PARAM].getValue();
+      if (inputs[WINDOW_WIDTH_INPUT].isConnected())
+      {
+         window_width += (int)std::round(inputs[WINDOW_WIDTH_INPUT].getVoltage() / 10.f * 16.f);
+      }
+      if (inputs[WINDOW_POS_INPUT].isConnected())
+      {
+         window_pos += (int)std::round(inputs[WINDOW_POS_INPUT].getVoltage() / 10.f * 16.f);
+      }
+      window_width = clamp(window_width, 1, 16);
+      window_pos = ((window_pos % 16) + 16) % 16;
+      return WriteWindow<uint16_t>::mask(rtl, window_width, window_pos);
+   }
+
+   // steps through the loaded tape file instead of generating the next tape value.
+   // the worker thread in `player` keeps the pages ahead of `play_pos` resident.
+   void stepPlayback(size_t length)
+   {
+      if (inputs[SCRUB_INPUT].isConnected())
+      {
+         float scrub = clamp(inputs[SCRUB_INPUT].getVoltage() / 10.f, 0.f, 1.f);
+         play_pos = (size_t)(scrub * (length - 1));
+      }
+      else if (play_pos >= length)
+      {
+         play_pos = playback_loop ? 0 : length - 1;
+      }
+      player.seek(play_pos);
+      // holds the previous value until the worker has paged a scrub target in, rather than reading it from disk here
+      if (player.read(play_pos, tape))
+      {
+         play_pos++;
+      }
+   }
+
    const int PARAM_INTERVAL = 64;
    int check_params = 0;
    void processParams()
    {
       prob = params[PROBABILITY_PARAM].getValue();
-      clear = params[CLEAR_PARAM].getValue();
-      set = params[SET_PARAM].getValue();
       shift_amt = params[SHIFT_PARAM].getValue();
       rtl = params[DIR_PARAM].getValue();
-   }
-
-   void process(const ProcessArgs &args) override
-   {
-      if (++check_params > PARAM_INTERVAL)
+      if (morph_snap_trigger.process(params[MORPH_SNAP_PARAM].getValue() > 0.f))
       {
-         check_params = 0;
-         processParams();
+         morph_snapshot = tape;
+      }
+      if (pattern_button_trigger.process(params[PATTERN_LOAD_PARAM].getValue() > 0.f))
+      {
+         pattern_armed = true;
       }
+      // picks up weight and range changes made from the menu
+      updateDacOutputs();
+   }
 
-      if (inputs[SHIFT_INPUT].isConnected())
+   // reads the control inputs whose sampling matches `on_clock`: continuous ones every sample, clocked ones on each clock edge only.
+   // a template so the per-sample read inlines into processTape instead of being a call on every sample.
+   template <bool on_clock>
+   void readControlInputs()
+   {
+      if (sample_on_clock[SAMPLE_SHIFT] == on_clock && inputs[SHIFT_INPUT].isConnected())
       {
          shift_amt = (int)((inputs[SHIFT_INPUT].getVoltage() / 10.f) * 15.f);
       }
 
-      if (inputs[DIR_INPUT].isConnected())
+      // direction edges are caught every sample whatever the sampling, so a trigger between clocks is never lost.
+      // on clock they are latched and the toggle lands on the next clock.
+      if (!on_clock && inputs[DIR_INPUT].isConnected() && dir_trigger.process(inputs[DIR_INPUT].getVoltage()))
       {
-         if (dir_trigger.process(inputs[DIR_INPUT].getVoltage()))
-         {
-            rtl = !rtl;
-            getParamQuantity(DIR_PARAM)->setValue(rtl);
-         }
+         dir_pending = !dir_pending;
       }
-
-      if (params[CLEAR_PARAM].getValue() > 0.f || inputs[CLEAR_INPUT].getVoltage() > 5.f)
+      if (dir_pending && (on_clock || !sample_on_clock[SAMPLE_DIR]))
       {
-         clear = true;
+         dir_pending = false;
+         rtl = !rtl;
+         getParamQuantity(DIR_PARAM)->setValue(rtl);
       }
-      else
+
+      if (sample_on_clock[SAMPLE_CLEAR] == on_clock)
       {
-         clear = false;
+         clear = params[CLEAR_PARAM].getValue() > 0.f || inputs[CLEAR_INPUT].getVoltage() > 5.f;
       }
-      if (params[SET_PARAM].getValue() > 0.f || inputs[SET_INPUT].getVoltage() > 5.f)
+      if (sample_on_clock[SAMPLE_SET] == on_clock)
       {
-         set = true;
+         set = params[SET_PARAM].getValue() > 0.f || inputs[SET_INPUT].getVoltage() > 5.f;
       }
-      else
+
+      if (sample_on_clock[SAMPLE_PROB] == on_clock && inputs[PROB_INPUT].isConnected())
       {
-         set = false;
+         prob = clamp(params[PROBABILITY_PARAM].getValue() + inputs[PROB_INPUT].getVoltage() / 10.f * params[PROB_CV_PARAM].getValue(), 0.f, 1.f);
       }
+   }
 
-      noise = random::uniform();
+   void process(const ProcessArgs &args) override
+   {
+#ifdef TURINGSBITS_PROFILE
+      uint64_t start = cycleCount();
+      bool edge = processTape(args);
+      profiler.record(start, cycleCount() - start, edge, profileTags());
+#else
+      processTape(args);
+#endif
+   }
 
-      float clock_input = inputs[CLOCK_INPUT].getVoltage();
-      bool new_clock = clock.process(clock_input);
+#ifdef TURINGSBITS_PROFILE
+   // packs the modes that change the cost of a sample, so spikes can be attributed to them
+   uint32_t profileTags()
+   {
+      return bit_pulse_mode | random_pulse_mode << 2 | clock_mode << 4 | set << 6 | clear << 7 | playback << 8;
+   }
 
-      if (new_clock)
+   std::string describeProfileTags(uint32_t tags)
+   {
+      auto label = [&](size_t mode)
+      { return "\"" + (mode < mode_labels.size() ? mode_labels[mode] : std::to_string(mode)) + "\""; };
+      return "\"bit_pulse_mode\":" + label(tags & 3) +
+             ",\"random_pulse_mode\":" + label(tags >> 2 & 3) +
+             ",\"clock_source\":\"" + clock_mode_labels[std::min<size_t>(tags >> 4 & 3, clock_mode_labels.size() - 1)] + "\"" +
+             ",\"set\":" + ((tags >> 6 & 1) ? "true" : "false") +
+             ",\"clear\":" + ((tags >> 7 & 1) ? "true" : "false") +
+             ",\"playback\":" + ((tags >> 8 & 1) ? "true" : "false");
+   }
+#endif
+
+   // advances the tape by one clock edge and updates everything that only changes on an edge
+   void stepTape()
+   {
+      readControlInputs<true>();
+      bool write = writeGate();
+
+      size_t play_length = playback ? player.length() : 0;
+
+      if (play_length > 0)
+      {
+         stepPlayback(play_length);
+         bit_toggled = false;
+      }
+      else if (write || pattern_armed)
+      {
+         // a written value or a loaded pattern replaces the tape, so there is no shift or random flip to report
+         bit_toggled = false;
+      }
+      else
       {
          // tape = (tape >> shift_amt) | (tape << (16 - shift_amt));
          // tape = std::rotr(tape, shift_amt);
@@ -307,39 +851,159 @@ struct TapeMachineModule : Module
          {
             bit_toggled = false;
          }
+      }
+
+      if (write)
+      {
+         tape = sampleWriteInput();
+      }
 
+      if (pattern_armed)
+      {
+         tape = selectedPattern();
+         pattern_armed = false;
+      }
+
+      if (clear || set)
+      {
+         uint16_t window = windowMask();
          if (clear)
          {
-            // tape &= (~masks[15]);
-            for (int i = 0; i < shift_amt; i++)
+            tape &= ~window;
+         }
+         if (set)
+         {
+            tape |= window;
+         }
+      }
+
+      out_tape = morphView();
+      updateDacOutputs();
+
+      stats.step(out_tape);
+      outputs[DENSITY_OUTPUT].setVoltage(stats.density / 1.6f);
+      outputs[RUN_OUTPUT].setVoltage(stats.longest_run / 1.6f);
+      outputs[TRANSITIONS_OUTPUT].setVoltage(stats.transitions / 1.6f);
+      outputs[ENTROPY_OUTPUT].setVoltage(stats.entropy * 10.f);
+
+      // an unconnected output is not evaluated, its state catches up on the first clock after plugging in
+      for (int i = 0; i < LOGIC_COUNT; i++)
+      {
+         if (!outputs[LOGIC_OUTPUT + i].isConnected())
+         {
+            // a pulse cut off by pulling the cable must not finish when it is plugged back in
+            logic_pulses[i].reset();
+            continue;
+         }
+         logic_programs[i].update();
+         logic_state[i] = logic_programs[i].read().eval(out_tape);
+         if (logic_state[i] && bit_pulse_mode == 0)
+         {
+            logic_pulses[i].trigger(0.01f);
+         }
+      }
+   }
+
+   // the dac only moves with the tape, its weights or its ranges, so its outputs are written on clock edges and param reads
+   // rather than every sample. kept out of line: inlined into processTape, the code slowed down every sample.
+   [[gnu::noinline]] void updateDacOutputs()
+   {
+      dac.update(out_tape);
+      for (int i = 0; i < WeightedDac::TAPS; i++)
+      {
+         outputs[DAC_OUTPUT + i].setVoltage(dac_ranges[i].map(dac.values[i]));
+      }
+   }
+
+   // one sample of the tape machine. returns whether a clock edge was processed.
+   bool processTape(const ProcessArgs &args)
+   {
+      if (++check_params > PARAM_INTERVAL)
+      {
+         check_params = 0;
+         processParams();
+         // the lights only have to keep up with the ui
+         lights[CLEAR_LIGHT].setBrightness(clear ? 1.0f : 0.0f);
+         lights[SET_LIGHT].setBrightness(set ? 1.0f : 0.0f);
+         lights[WRITE_LIGHT].setBrightness(writeGate() ? 1.0f : 0.0f);
+      }
+
+      readControlInputs<false>();
+      if (inputs[PATTERN_LOAD_INPUT].isConnected() && pattern_load_trigger.process(inputs[PATTERN_LOAD_INPUT].getVoltage()))
+      {
+         pattern_armed = true;
+      }
+
+      float clock_input = 0.f;
+      bool new_clock = false;
+      bool publishing = false;
+      int slot = group_slot.load(std::memory_order_relaxed);
+      group_tape_valid = false;
+      bool leader = slot >= 0 && TapeGroup::get(slot / TapeGroup::MEMBERS).leads(slot % TapeGroup::MEMBERS);
+      // followers take the leader's clock and random word, with no edge detection or random draw of their own
+      bool followed = slot >= 0 && !leader && followGroup(slot, args.frame, new_clock, clock_input);
+      if (!followed)
+      {
+         if (group_followed)
+         {
+            // the trigger saw nothing while following, its stale state must not fire an edge
+            clock.reset();
+            clock_gen.reset();
+         }
+         noise = random::uniform();
+         clock_input = inputs[CLOCK_INPUT].getVoltage();
+         new_clock = clock.process(clock_input);
+
+         if (clock_mode != ClockGen::EXTERNAL)
+         {
+            int ratio = (int)params[RATIO_PARAM].getValue();
+            if (inputs[RATIO_INPUT].isConnected())
             {
-               tape &= (~masks[15 << i]);
+               ratio += (int)std::round(inputs[RATIO_INPUT].getVoltage());
             }
+            new_clock = clock_gen.process(clock_mode, params[BPM_PARAM].getValue(), ratio, new_clock, clock.isHigh(), args.sampleTime);
+            clock_input = clock_gen.gate ? 10.f : 0.f;
          }
 
-         if (set)
+         if (leader)
          {
-            // tape |= masks[15];
-            for (int i = 0; i < shift_amt; i++)
+            // the leader steps on its own edge and publishes the tape it stepped to for the followers' next frame
+            TapeGroup &leading = TapeGroup::get(slot / TapeGroup::MEMBERS);
+            publishing = leading.beginPublish(args.frame, new_clock, clock_input, hasClockSource());
+            if (!publishing)
             {
-               tape |= masks[15 << i];
+               // another member took the lead this frame
+               new_clock = false;
+            }
+            else if (new_clock)
+            {
+               noise = leading.word(args.frame, group_correlated ? 0 : slot % TapeGroup::MEMBERS) * (1.f / 4294967296.f);
             }
          }
       }
+      group_followed = followed;
+      outputs[CLOCK_OUTPUT].setVoltage(clock_input);
 
-      lights[CLEAR_LIGHT].setBrightness(clear ? 1.0f : 0.0f);
-      lights[SET_LIGHT].setBrightness(set ? 1.0f : 0.0f);
+      if (new_clock)
+      {
+         stepTape();
+      }
+
+      if (publishing)
+      {
+         TapeGroup::get(slot / TapeGroup::MEMBERS).finishPublish(args.frame, tape);
+      }
 
-      uint16_t flipped_tape = (~tape);
-      float voltage = voltage_range.map(tape / 65535.f);
+      uint16_t flipped_tape = (~out_tape);
+      float voltage = voltage_range.map(out_tape / 65535.f);
       float flipped_voltage = flipped_voltage_range.map(flipped_tape / 65535.f);
 
       outputs[VOLTAGE_OUTPUT].setVoltage(voltage);
       outputs[FLIPPED_OUTPUT].setVoltage(flipped_voltage);
 
-      float min_voltage = flipped_tape ^ ((tape ^ flipped_tape) & -(tape < flipped_tape));
+      float min_voltage = flipped_tape ^ ((out_tape ^ flipped_tape) & -(out_tape < flipped_tape));
       min_voltage = min_voltage_range.map(min_voltage / 65535.f);
-      float max_voltage = tape ^ ((tape ^ flipped_tape) & -(tape < flipped_tape));
+      float max_voltage = out_tape ^ ((out_tape ^ flipped_tape) & -(out_tape < flipped_tape));
       max_voltage = max_voltage_range.map(max_voltage / 65535.f);
 
       outputs[MIN_OUTPUT].setVoltage(min_voltage);
@@ -354,7 +1018,7 @@ struct TapeMachineModule : Module
       case 0: // trigger
          for (int i = 0; i < 16; i++)
          {
-            if (new_clock && (tape & masks[i]))
+            if (new_clock && (out_tape & masks[i]))
             {
                bit_pulses[i].trigger(0.01f);
                light_pulses[i].trigger(0.05f);
@@ -362,32 +1026,54 @@ struct TapeMachineModule : Module
             bool bp = bit_pulses[i].process(args.sampleTime);
             bool lp = light_pulses[i].process(args.sampleTime);
             outputs[PULSE_OUTPUT + i].setVoltage(bp ? 10.f : 0.f);
-            lights[BIT_LIGHT + i].setBrightness(((tape & masks[i]) && lp) ? 1.f : 0.f);
+            lights[BIT_LIGHT + i].setBrightness(((out_tape & masks[i]) && lp) ? 1.f : 0.f);
          }
          break;
       case 1: // clock
          for (int i = 0; i < 16; i++)
          {
-            outputs[PULSE_OUTPUT + i].setVoltage((tape & masks[i]) ? clock_input : 0.f);
-            lights[BIT_LIGHT + i].setBrightness(((tape & masks[i]) && clock_input > 0.5f) ? 1.f : 0.f);
+            outputs[PULSE_OUTPUT + i].setVoltage((out_tape & masks[i]) ? clock_input : 0.f);
+            lights[BIT_LIGHT + i].setBrightness(((out_tape & masks[i]) && clock_input > 0.5f) ? 1.f : 0.f);
          }
          break;
       case 2: // hold
          for (int i = 0; i < 16; i++)
          {
-            outputs[PULSE_OUTPUT + i].setVoltage((tape & masks[i]) ? 10.f : 0.f);
-            lights[BIT_LIGHT + i].setBrightness((tape & masks[i]) ? 1.f : 0.f);
+            outputs[PULSE_OUTPUT + i].setVoltage((out_tape & masks[i]) ? 10.f : 0.f);
+            lights[BIT_LIGHT + i].setBrightness((out_tape & masks[i]) ? 1.f : 0.f);
          }
          break;
       default: // clock (1, default)
          for (int i = 0; i < 16; i++)
          {
-            outputs[PULSE_OUTPUT + i].setVoltage((tape & masks[i]) ? clock_input : 0.f);
-            lights[BIT_LIGHT + i].setBrightness(((tape & masks[i]) && clock_input > 0.5f) ? 1.f : 0.f);
+            outputs[PULSE_OUTPUT + i].setVoltage((out_tape & masks[i]) ? clock_input : 0.f);
+            lights[BIT_LIGHT + i].setBrightness(((out_tape & masks[i]) && clock_input > 0.5f) ? 1.f : 0.f);
          }
          break;
       }
 
+      for (int i = 0; i < LOGIC_COUNT; i++)
+      {
+         if (!outputs[LOGIC_OUTPUT + i].isConnected())
+         {
+            continue;
+         }
+         float logic_voltage;
+         switch (bit_pulse_mode)
+         {
+         case 0: // trigger
+            logic_voltage = logic_pulses[i].process(args.sampleTime) ? 10.f : 0.f;
+            break;
+         case 2: // hold
+            logic_voltage = logic_state[i] ? 10.f : 0.f;
+            break;
+         default: // clock (1, default)
+            logic_voltage = logic_state[i] ? clock_input : 0.f;
+            break;
+         }
+         outputs[LOGIC_OUTPUT + i].setVoltage(logic_voltage);
+      }
+
       switch (random_pulse_mode)
       {
       case 0: // trigger
@@ -403,136 +1089,234 @@ struct TapeMachineModule : Module
          outputs[RANDOM_PULSE_OUTPUT].setVoltage(bit_toggled ? clock_input : 0.f);
          break;
       }
+
+      return new_clock;
    }
 };
 
+enum PanelComponent
+{
+   LARGE_KNOB,
+   SMALL_KNOB,
+   BUTTON,
+   SWITCH,
+   INPUT,
+   OUTPUT,
+   RED_LIGHT,
+   GREEN_LIGHT,
+   BLUE_LIGHT,
+   YELLOW_LIGHT
+};
+
+// one widget, or a row of `count` widgets `step` grid units apart with ids `id_step` apart. positions in grid units.
+struct PanelPlacement
+{
+   PanelComponent component;
+   int id;
+   float x;
+   float y;
+   int count = 1;
+   float step = 2;
+   int id_step = 1;
+};
+
 struct TapeMachineModuleWidget : ModuleWidget
 {
+   // each control sits next to its cv input: probability beside its knob, shift with clock and direction,
+   // morph and pattern in their own runs, and the dac outputs along the bottom with write and scrub.
+   static constexpr PanelPlacement LAYOUT[] = {
+       {LARGE_KNOB, TapeMachineModule::PROBABILITY_PARAM, 3, 5},
+       {SMALL_KNOB, TapeMachineModule::PROB_CV_PARAM, 7, 5},
+       {INPUT, TapeMachineModule::PROB_INPUT, 9, 5},
+       {BUTTON, TapeMachineModule::CLEAR_PARAM, 13, 5},
+       {INPUT, TapeMachineModule::CLEAR_INPUT, 15, 5},
+       {GREEN_LIGHT, TapeMachineModule::CLEAR_LIGHT, 17, 5},
+       {BUTTON, TapeMachineModule::SET_PARAM, 13, 7},
+       {INPUT, TapeMachineModule::SET_INPUT, 15, 7},
+       {BLUE_LIGHT, TapeMachineModule::SET_LIGHT, 17, 7},
+       {SMALL_KNOB, TapeMachineModule::WINDOW_POS_PARAM, 11, 5},
+       {SMALL_KNOB, TapeMachineModule::WINDOW_WIDTH_PARAM, 7, 7},
+       {INPUT, TapeMachineModule::WINDOW_WIDTH_INPUT, 9, 7},
+       {INPUT, TapeMachineModule::WINDOW_POS_INPUT, 11, 7},
+       {SMALL_KNOB, TapeMachineModule::BPM_PARAM, 19, 5},
+       {SMALL_KNOB, TapeMachineModule::RATIO_PARAM, 19, 7},
+       {INPUT, TapeMachineModule::RATIO_INPUT, 19, 9},
+       {OUTPUT, TapeMachineModule::CLOCK_OUTPUT, 19, 11},
+       {INPUT, TapeMachineModule::CLOCK_INPUT, 3, 9},
+       {SWITCH, TapeMachineModule::DIR_PARAM, 5, 9},
+       {INPUT, TapeMachineModule::DIR_INPUT, 7, 9},
+       {SMALL_KNOB, TapeMachineModule::SHIFT_PARAM, 9, 9},
+       {INPUT, TapeMachineModule::SHIFT_INPUT, 11, 9},
+       {SMALL_KNOB, TapeMachineModule::MORPH_PARAM, 13, 9},
+       {INPUT, TapeMachineModule::MORPH_INPUT, 15, 9},
+       {BUTTON, TapeMachineModule::MORPH_SNAP_PARAM, 17, 9},
+       {OUTPUT, TapeMachineModule::VOLTAGE_OUTPUT, 3, 11},
+       {OUTPUT, TapeMachineModule::FLIPPED_OUTPUT, 5, 11},
+       {OUTPUT, TapeMachineModule::MIN_OUTPUT, 7, 11},
+       {OUTPUT, TapeMachineModule::MAX_OUTPUT, 9, 11},
+       {SMALL_KNOB, TapeMachineModule::PATTERN_PARAM, 11, 11},
+       {INPUT, TapeMachineModule::PATTERN_INPUT, 13, 11},
+       {BUTTON, TapeMachineModule::PATTERN_LOAD_PARAM, 15, 11},
+       {INPUT, TapeMachineModule::PATTERN_LOAD_INPUT, 17, 11},
+       {OUTPUT, TapeMachineModule::DENSITY_OUTPUT, 3, 13},
+       {OUTPUT, TapeMachineModule::RUN_OUTPUT, 5, 13},
+       {OUTPUT, TapeMachineModule::TRANSITIONS_OUTPUT, 7, 13},
+       {OUTPUT, TapeMachineModule::ENTROPY_OUTPUT, 9, 13},
+       {OUTPUT, TapeMachineModule::RANDOM_PULSE_OUTPUT, 11, 13},
+       {OUTPUT, TapeMachineModule::LOGIC_OUTPUT, 13, 13, TapeMachineModule::LOGIC_COUNT},
+       {RED_LIGHT, TapeMachineModule::BIT_LIGHT + 15, 2, 15, 8, 2.5, -1},
+       {OUTPUT, TapeMachineModule::PULSE_OUTPUT + 15, 2, 16.5, 8, 2.5, -1},
+       {RED_LIGHT, TapeMachineModule::BIT_LIGHT + 7, 2, 18.5, 8, 2.5, -1},
+       {OUTPUT, TapeMachineModule::PULSE_OUTPUT + 7, 2, 20, 8, 2.5, -1},
+       {BUTTON, TapeMachineModule::WRITE_PARAM, 3, 22},
+       {INPUT, TapeMachineModule::WRITE_GATE_INPUT, 5, 22},
+       {YELLOW_LIGHT, TapeMachineModule::WRITE_LIGHT, 7, 22},
+       {INPUT, TapeMachineModule::WRITE_INPUT, 9, 22},
+       {INPUT, TapeMachineModule::SCRUB_INPUT, 11, 22},
+       {OUTPUT, TapeMachineModule::DAC_OUTPUT, 13, 22, WeightedDac::TAPS},
+   };
+
    TapeMachineModuleWidget(TapeMachineModule *module)
    {
       setModule(module);
       setPanel(createPanel(asset::plugin(pluginInstance, "res/tape-machine.svg")));
 
-      float dx = RACK_GRID_WIDTH;
-      float dy = RACK_GRID_WIDTH;
-      float x_start = dx * 3;
-      float y_start = dy * 5;
-      float x = x_start;
-      float y = y_start;
-
-      addParam(createParamCentered<LargeBitKnob>(Vec(x, y), module, TapeMachineModule::PROBABILITY_PARAM));
-      x += dx * 4;
-      addParam(createParamCentered<SmallBitKnob>(Vec(x, y), module, TapeMachineModule::SHIFT_PARAM));
-      x += dx * 2;
-      addInput(createInputCentered<BitPort>(Vec(x, y), module, TapeMachineModule::SHIFT_INPUT));
-      x += dx * 4;
-      addParam(createParamCentered<LEDButton>(Vec(x, y), module, TapeMachineModule::CLEAR_PARAM));
-      x += dx * 2;
-      addInput(createInputCentered<BitPort>(Vec(x, y), module, TapeMachineModule::CLEAR_INPUT));
-      x += dx * 2;
-      addChild(createLightCentered<MediumLight<GreenLight>>(Vec(x, y), module, TapeMachineModule::CLEAR_LIGHT));
-      x -= dx * 4;
-      y += dy * 2;
-      addParam(createParamCentered<LEDButton>(Vec(x, y), module, TapeMachineModule::SET_PARAM));
-      x += dx * 2;
-      addInput(createInputCentered<BitPort>(Vec(x, y), module, TapeMachineModule::SET_INPUT));
-      x += dx * 2;
-      addChild(createLightCentered<MediumLight<BlueLight>>(Vec(x, y), module, TapeMachineModule::SET_LIGHT));
-      x -= dx * 10;
-      x -= dx * 4;
-      y += dy * 2;
-      addInput(createInputCentered<BitPort>(Vec(x, y), module, TapeMachineModule::CLOCK_INPUT));
-      x += dx * 2;
-      addParam(createParamCentered<CKSS>(Vec(x, y), module, TapeMachineModule::DIR_PARAM));
-      x += dx * 2;
-      addInput(createInputCentered<BitPort>(Vec(x, y), module, TapeMachineModule::DIR_INPUT));
-      x -= dx * 4;
-      y += dy * 2;
-      addOutput(createOutputCentered<BitPort>(Vec(x, y), module, TapeMachineModule::VOLTAGE_OUTPUT));
-      x += dx * 2;
-      addOutput(createOutputCentered<BitPort>(Vec(x, y), module, TapeMachineModule::FLIPPED_OUTPUT));
-      x += dx * 2;
-      addOutput(createOutputCentered<BitPort>(Vec(x, y), module, TapeMachineModule::MIN_OUTPUT));
-      x += dx * 2;
-      addOutput(createOutputCentered<BitPort>(Vec(x, y), module, TapeMachineModule::MAX_OUTPUT));
-      x += dx * 2;
-      addOutput(createOutputCentered<BitPort>(Vec(x, y), module, TapeMachineModule::RANDOM_PULSE_OUTPUT));
-      x -= dx * 9;
-      y += dy * 4;
-      addChild(createLightCentered<MediumLight<RedLight>>(Vec(x, y), module, TapeMachineModule::BIT_LIGHT + 15));
-      x += dx * 2.5;
-      addChild(createLightCentered<MediumLight<RedLight>>(Vec(x, y), module, TapeMachineModule::BIT_LIGHT + 14));
-      x += dx * 2.5;
-      addChild(createLightCentered<MediumLight<RedLight>>(Vec(x, y), module, TapeMachineModule::BIT_LIGHT + 13));
-      x += dx * 2.5;
-      addChild(createLightCentered<MediumLight<RedLight>>(Vec(x, y), module, TapeMachineModule::BIT_LIGHT + 12));
-      x += dx * 2.5;
-      addChild(createLightCentered<MediumLight<RedLight>>(Vec(x, y), module, TapeMachineModule::BIT_LIGHT + 11));
-      x += dx * 2.5;
-      addChild(createLightCentered<MediumLight<RedLight>>(Vec(x, y), module, TapeMachineModule::BIT_LIGHT + 10));
-      x += dx * 2.5;
-      addChild(createLightCentered<MediumLight<RedLight>>(Vec(x, y), module, TapeMachineModule::BIT_LIGHT + 9));
-      x += dx * 2.5;
-      addChild(createLightCentered<MediumLight<RedLight>>(Vec(x, y), module, TapeMachineModule::BIT_LIGHT + 8));
-      x -= dx * 17.5;
-      y += dy * 1.5;
-      addOutput(createOutputCentered<BitPort>(Vec(x, y), module, TapeMachineModule::PULSE_OUTPUT + 15));
-      x += dx * 2.5;
-      addOutput(createOutputCentered<BitPort>(Vec(x, y), module, TapeMachineModule::PULSE_OUTPUT + 14));
-      x += dx * 2.5;
-      addOutput(createOutputCentered<BitPort>(Vec(x, y), module, TapeMachineModule::PULSE_OUTPUT + 13));
-      x += dx * 2.5;
-      addOutput(createOutputCentered<BitPort>(Vec(x, y), module, TapeMachineModule::PULSE_OUTPUT + 12));
-      x += dx * 2.5;
-      addOutput(createOutputCentered<BitPort>(Vec(x, y), module, TapeMachineModule::PULSE_OUTPUT + 11));
-      x += dx * 2.5;
-      addOutput(createOutputCentered<BitPort>(Vec(x, y), module, TapeMachineModule::PULSE_OUTPUT + 10));
-      x += dx * 2.5;
-      addOutput(createOutputCentered<BitPort>(Vec(x, y), module, TapeMachineModule::PULSE_OUTPUT + 9));
-      x += dx * 2.5;
-      addOutput(createOutputCentered<BitPort>(Vec(x, y), module, TapeMachineModule::PULSE_OUTPUT + 8));
-      x -= dx * 17.5;
-      y += dy * 2;
-      addChild(createLightCentered<MediumLight<RedLight>>(Vec(x, y), module, TapeMachineModule::BIT_LIGHT + 7));
-      x += dx * 2.5;
-      addChild(createLightCentered<MediumLight<RedLight>>(Vec(x, y), module, TapeMachineModule::BIT_LIGHT + 6));
-      x += dx * 2.5;
-      addChild(createLightCentered<MediumLight<RedLight>>(Vec(x, y), module, TapeMachineModule::BIT_LIGHT + 5));
-      x += dx * 2.5;
-      addChild(createLightCentered<MediumLight<RedLight>>(Vec(x, y), module, TapeMachineModule::BIT_LIGHT + 4));
-      x += dx * 2.5;
-      addChild(createLightCentered<MediumLight<RedLight>>(Vec(x, y), module, TapeMachineModule::BIT_LIGHT + 3));
-      x += dx * 2.5;
-      addChild(createLightCentered<MediumLight<RedLight>>(Vec(x, y), module, TapeMachineModule::BIT_LIGHT + 2));
-      x += dx * 2.5;
-      addChild(createLightCentered<MediumLight<RedLight>>(Vec(x, y), module, TapeMachineModule::BIT_LIGHT + 1));
-      x += dx * 2.5;
-      addChild(createLightCentered<MediumLight<RedLight>>(Vec(x, y), module, TapeMachineModule::BIT_LIGHT + 0));
-      x -= dx * 17.5;
-      y += dy * 1.5;
-      addOutput(createOutputCentered<BitPort>(Vec(x, y), module, TapeMachineModule::PULSE_OUTPUT + 7));
-      x += dx * 2.5;
-      addOutput(createOutputCentered<BitPort>(Vec(x, y), module, TapeMachineModule::PULSE_OUTPUT + 6));
-      x += dx * 2.5;
-      addOutput(createOutputCentered<BitPort>(Vec(x, y), module, TapeMachineModule::PULSE_OUTPUT + 5));
-      x += dx * 2.5;
-      addOutput(createOutputCentered<BitPort>(Vec(x, y), module, TapeMachineModule::PULSE_OUTPUT + 4));
-      x += dx * 2.5;
-      addOutput(createOutputCentered<BitPort>(Vec(x, y), module, TapeMachineModule::PULSE_OUTPUT + 3));
-      x += dx * 2.5;
-      addOutput(createOutputCentered<BitPort>(Vec(x, y), module, TapeMachineModule::PULSE_OUTPUT + 2));
-      x += dx * 2.5;
-      addOutput(createOutputCentered<BitPort>(Vec(x, y), module, TapeMachineModule::PULSE_OUTPUT + 1));
-      x += dx * 2.5;
-      addOutput(createOutputCentered<BitPort>(Vec(x, y), module, TapeMachineModule::PULSE_OUTPUT + 0));
+      for (const PanelPlacement &p : LAYOUT)
+      {
+         for (int i = 0; i < p.count; i++)
+         {
+            Vec pos = Vec(p.x + p.step * i, p.y).mult(RACK_GRID_WIDTH);
+            int id = p.id + p.id_step * i;
+            switch (p.component)
+            {
+            case LARGE_KNOB:
+               addParam(createParamCentered<LargeBitKnob>(pos, module, id));
+               break;
+            case SMALL_KNOB:
+               addParam(createParamCentered<SmallBitKnob>(pos, module, id));
+               break;
+            case BUTTON:
+               addParam(createParamCentered<LEDButton>(pos, module, id));
+               break;
+            case SWITCH:
+               addParam(createParamCentered<CKSS>(pos, module, id));
+               break;
+            case INPUT:
+               addInput(createInputCentered<BitPort>(pos, module, id));
+               break;
+            case OUTPUT:
+               addOutput(createOutputCentered<BitPort>(pos, module, id));
+               break;
+            case RED_LIGHT:
+               addChild(createLightCentered<MediumLight<RedLight>>(pos, module, id));
+               break;
+            case GREEN_LIGHT:
+               addChild(createLightCentered<MediumLight<GreenLight>>(pos, module, id));
+               break;
+            case BLUE_LIGHT:
+               addChild(createLightCentered<MediumLight<BlueLight>>(pos, module, id));
+               break;
+            case YELLOW_LIGHT:
+               addChild(createLightCentered<MediumLight<YellowLight>>(pos, module, id));
+               break;
+            }
+         }
+      }
    }
 
+   // edits one logic expression. recompiles on every change, invalid expressions output nothing.
+   struct LogicTextField : ui::TextField
+   {
+      TapeMachineModule *module;
+      int index;
+
+      LogicTextField(TapeMachineModule *module, int index)
+      {
+         this->module = module;
+         this->index = index;
+         box.size.x = 200;
+         placeholder = "e.g. b3 & !b7 ^ b12";
+         text = module->logic_exprs[index];
+      }
+
+      void onChange(const ChangeEvent &e) override
+      {
+         module->setLogicExpression(index, text);
+      }
+   };
+
+   // edits the weight of one bit of one dac tap.
+   struct DacWeightQuantity : Quantity
+   {
+      WeightedDac *dac;
+      int tap;
+      int bit;
+
+      DacWeightQuantity(WeightedDac *dac, int tap, int bit)
+      {
+         this->dac = dac;
+         this->tap = tap;
+         this->bit = bit;
+      }
+
+      void setValue(float value) override { dac->setWeight(tap, bit, value); }
+      float getValue() override { return dac->getWeight(tap, bit); }
+      float getMinValue() override { return 0.f; }
+      float getMaxValue() override { return 1.f; }
+      std::string getLabel() override { return "bit 2^" + std::to_string(bit); }
+   };
+
+   struct DacWeightSlider : ui::Slider
+   {
+      DacWeightSlider(WeightedDac *dac, int tap, int bit)
+      {
+         quantity = new DacWeightQuantity(dac, tap, bit);
+         box.size.x = 200.f;
+      }
+      ~DacWeightSlider()
+      {
+         delete quantity;
+      }
+   };
+
    void appendContextMenu(Menu *menu) override
    {
       TapeMachineModule *module = dynamic_cast<TapeMachineModule *>(this->module);
       assert(module);
 
       menu->addChild(new MenuSeparator());
+      menu->addChild(createIndexSubmenuItem("clock source", module->clock_mode_labels, [=]
+                                            { return module->getClockMode(); }, [=](size_t mode)
+                                            { module->setClockMode(mode); }));
+      menu->addChild(createSubmenuItem("cv sampling", "", [=](Menu *menu)
+                                       {
+         for (int i = 0; i < TapeMachineModule::NUM_SAMPLED; i++)
+         {
+            menu->addChild(createIndexSubmenuItem(module->sampled_labels[i], {"continuous", "on clock"}, [=]
+                                                  { return (size_t)module->sample_on_clock[i]; }, [=](size_t mode)
+                                                  { module->sample_on_clock[i] = mode; }));
+         } }));
+      menu->addChild(createIndexSubmenuItem("write encoding", {"binary", "gray code"}, [=]
+                                            { return (size_t)module->write_gray; }, [=](size_t mode)
+                                            { module->write_gray = mode; }));
+      menu->addChild(createSubmenuItem("group", "", [=](Menu *menu)
+                                       {
+         menu->addChild(createIndexSubmenuItem("group", TapeGroup::groupLabels(), [=]
+                                               { return (size_t)(module->group + 1); }, [=](size_t g)
+                                               { module->setGroup((int)g - 1); }));
+         int slot = module->group_slot;
+         int member = slot % TapeGroup::MEMBERS;
+         bool leader = slot >= 0 && TapeGroup::get(slot / TapeGroup::MEMBERS).leads(member);
+         menu->addChild(createMenuLabel(slot < 0 ? "not in a group" : (leader ? "leader" : "follower " + std::to_string(member))));
+         menu->addChild(createIndexSubmenuItem("random", {"decorrelated", "correlated"}, [=]
+                                               { return (size_t)module->group_correlated; }, [=](size_t mode)
+                                               { module->group_correlated = mode; })); }));
+      menu->addChild(createIndexSubmenuItem("pattern bank", PatternLibrary::bankLabels(), [=]
+                                            { return module->pattern_bank; }, [=](size_t bank)
+                                            { module->pattern_bank = bank; }));
+      menu->addChild(createIndexSubmenuItem("morph target", {"snapshot", "group leader"}, [=]
+                                            { return module->morph_source; }, [=](size_t source)
+                                            { module->morph_source = source; }));
       menu->addChild(createIndexSubmenuItem("bit pulse mode", module->mode_labels, [=]
                                             { return module->getBitMode(); }, [=](size_t mode)
                                             { module->setBitMode(mode); }));
@@ -544,6 +1328,82 @@ struct TapeMachineModuleWidget : ModuleWidget
       module->flipped_voltage_range.addMenu(module, menu, "flipped voltage range");
       module->min_voltage_range.addMenu(module, menu, "min voltage range");
       module->max_voltage_range.addMenu(module, menu, "max voltage range");
+      menu->addChild(createSubmenuItem("dac outputs", "", [=](Menu *menu)
+                                       {
+         for (int tap = 0; tap < WeightedDac::TAPS; tap++)
+         {
+            menu->addChild(createSubmenuItem("dac " + std::to_string(tap + 1), "", [=](Menu *menu)
+                                             {
+               module->dac_ranges[tap].addMenu(module, menu, "voltage range");
+               menu->addChild(createSubmenuItem("weights", "", [=](Menu *menu)
+                                                {
+                  for (int bit = WeightedDac::BITS - 1; bit >= 0; bit--)
+                  {
+                     menu->addChild(new DacWeightSlider(&module->dac, tap, bit));
+                  } }));
+               menu->addChild(new MenuSeparator());
+               std::vector<std::string> presets = WeightedDac::presetLabels();
+               for (int preset = 0; preset < WeightedDac::NUM_PRESETS; preset++)
+               {
+                  menu->addChild(createMenuItem(presets[preset], "", [=]()
+                                                { module->dac.setPreset(tap, preset); }));
+               } }));
+         } }));
+      menu->addChild(new MenuSeparator());
+      menu->addChild(createSubmenuItem("logic outputs", "", [=](Menu *menu)
+                                       {
+         menu->addChild(createMenuLabel("b0-b15, ! & ^ | ( )"));
+         for (int i = 0; i < TapeMachineModule::LOGIC_COUNT; i++)
+         {
+            menu->addChild(createMenuLabel("logic " + std::to_string(i + 1) + (module->logic_valid[i] ? "" : " (invalid)")));
+            menu->addChild(new LogicTextField(module, i));
+         } }));
+      menu->addChild(createSubmenuItem("playback", module->playback ? "on" : "off", [=](Menu *menu)
+                                       {
+         std::string path = module->player.path();
+         menu->addChild(createMenuLabel(path.empty() ? "no tape file loaded" : system::getFilename(path)));
+         menu->addChild(createMenuItem("load tape file...", "", [=]()
+                                       {
+            char *path = osdialog_file(OSDIALOG_OPEN, NULL, NULL, NULL);
+            if (path)
+            {
+               module->loadTapeFile(path);
+               std::free(path);
+            } }));
+         menu->addChild(createMenuItem("eject tape file", "", [=]()
+                                       { module->ejectTapeFile(); }, path.empty()));
+         menu->addChild(createBoolPtrMenuItem("play from tape file", "", &module->playback));
+         menu->addChild(createBoolPtrMenuItem("loop", "", &module->playback_loop)); }));
+#ifdef TURINGSBITS_PROFILE
+      menu->addChild(new MenuSeparator());
+      menu->addChild(createSubmenuItem("profile", "", [=](Menu *menu)
+                                       {
+         ProcessProfiler &profiler = module->profiler;
+         menu->addChild(createMenuLabel("edge p50 / p99: " + std::to_string(profiler.edge_hist.percentile(0.5f)) + " / " + std::to_string(profiler.edge_hist.percentile(0.99f)) + " cycles"));
+         menu->addChild(createMenuLabel("non-edge p50 / p99: " + std::to_string(profiler.other_hist.percentile(0.5f)) + " / " + std::to_string(profiler.other_hist.percentile(0.99f)) + " cycles"));
+         menu->addChild(createMenuLabel("samples: " + std::to_string(profiler.edge_hist.total.load() + profiler.other_hist.total.load())));
+         menu->addChild(createMenuItem("dump trace...", "", [=]()
+                                       {
+            char *path = osdialog_file(OSDIALOG_SAVE, NULL, ("tape-machine-" + std::to_string(module->id) + ".json").c_str(), NULL);
+            if (path)
+            {
+               module->profiler.dump(path, "tape machine " + std::to_string(module->id), [=](uint32_t tags)
+                                     { return module->describeProfileTags(tags); });
+               std::free(path);
+            } }));
+         menu->addChild(createMenuItem("reset", "", [=]()
+                                       { module->profiler.reset(); }));
+         menu->addChild(createMenuItem("time 50 patch loads", "", [=]()
+                                       {
+            json_t *state = module->dataToJson();
+            // the copies would otherwise join this instance's group and each map and page the tape file
+            json_object_del(state, "group");
+            json_object_del(state, "tape_file");
+            json_object_del(state, "playback");
+            PatchLoadTimes t = benchmarkPatchLoad<TapeMachineModule, TapeMachineModuleWidget>(50, state);
+            json_decref(state);
+            INFO("tape machine: 50 loads of this instance's state, per instance %.3f ms module, %.3f ms dataFromJson, %.3f ms panel, %.3f ms worst", t.module_ms, t.json_ms, t.panel_ms, t.worst_ms); })); }));
+#endif
    }
 };
 
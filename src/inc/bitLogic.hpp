@@ -0,0 +1,223 @@
+/*
+ * Description:
+ * bitLogic User-defined logic expressions over tape bits, compiled to a tiny bytecode.
+ *
+ * Syntax:
+ * - `b0` to `b15` read a tape bit, `0` and `1` are constants.
+ * - `!` or `~` negate, `&` and, `^` xor, `|` or, with C precedence (`!` > `&` > `^` > `|`).
+ * - parentheses group.
+ *
+ * Example: `b3 & !b7 ^ b12`
+ *
+ * Expressions are compiled once, on the UI thread, into a postfix program. Every instruction
+ * works on a stack held in the bits of a single word, so evaluating a program on the audio thread
+ * is a handful of shifts, masks and ands with no branches on the data.
+ */
+
+#pragma once
+
+#include "plugin.hpp"
+
+struct BitLogic
+{
+    /// Longest program a compiled expression can have. Longer expressions fail to compile.
+    static constexpr int MAX_OPS = 32;
+
+    /// Deepest the evaluation stack can grow (one bit per entry of a uint32_t).
+    static constexpr int MAX_DEPTH = 32;
+
+    enum OpCode : uint8_t
+    {
+        /// Push (tape & mask) != 0
+        PUSH,
+        /// Push the constant in mask (0 or 1)
+        CONST,
+        NOT,
+        AND,
+        XOR,
+        OR
+    };
+
+    struct Op
+    {
+        OpCode code;
+        uint16_t mask;
+    };
+
+    /// A compiled expression. An empty program always evaluates to false.
+    struct Program
+    {
+        Op ops[MAX_OPS];
+        int length = 0;
+
+        bool eval(uint16_t tape) const
+        {
+            uint32_t stack = 0;
+            for (int i = 0; i < length; i++)
+            {
+                const Op &op = ops[i];
+                switch (op.code)
+                {
+                case PUSH:
+                    stack = (stack << 1) | ((tape & op.mask) != 0);
+                    break;
+                case CONST:
+                    stack = (stack << 1) | op.mask;
+                    break;
+                case NOT:
+                    stack ^= 1;
+                    break;
+                case AND:
+                    stack = (stack >> 1) & (stack | ~1u);
+                    break;
+                case XOR:
+                    stack = (stack >> 1) ^ (stack & 1);
+                    break;
+                case OR:
+                    stack = (stack >> 1) | (stack & 1);
+                    break;
+                }
+            }
+            return stack & 1;
+        }
+    };
+
+    /**
+     * Compiles `text` into `program`.
+     *
+     * Returns false and leaves `program` empty if the expression is invalid. An empty expression compiles to an empty program.
+     */
+    static bool compile(const std::string &text, Program &program)
+    {
+        Parser parser{text.c_str(), &program};
+        program.length = 0;
+        parser.skipSpace();
+        if (!*parser.p)
+            return true;
+        if (!parser.parseOr() || *parser.p || parser.failed)
+        {
+            program.length = 0;
+            return false;
+        }
+        return true;
+    }
+
+private:
+    /// Recursive descent parser emitting postfix ops. One function per precedence level.
+    struct Parser
+    {
+        const char *p;
+        Program *program;
+        int depth = 0;
+        bool failed = false;
+
+        void skipSpace()
+        {
+            while (*p == ' ' || *p == '\t')
+                p++;
+        }
+
+        bool accept(char c)
+        {
+            skipSpace();
+            if (*p != c)
+                return false;
+            p++;
+            skipSpace();
+            return true;
+        }
+
+        bool emit(OpCode code, uint16_t mask = 0)
+        {
+            if (program->length >= MAX_OPS)
+                return fail();
+            depth += (code == PUSH || code == CONST) ? 1 : (code == NOT ? 0 : -1);
+            if (depth > MAX_DEPTH)
+                return fail();
+            program->ops[program->length++] = {code, mask};
+            return true;
+        }
+
+        bool fail()
+        {
+            failed = true;
+            return false;
+        }
+
+        bool parseOr()
+        {
+            if (!parseXor())
+                return false;
+            while (accept('|'))
+            {
+                if (!parseXor() || !emit(OR))
+                    return false;
+            }
+            return true;
+        }
+
+        bool parseXor()
+        {
+            if (!parseAnd())
+                return false;
+            while (accept('^'))
+            {
+                if (!parseAnd() || !emit(XOR))
+                    return false;
+            }
+            return true;
+        }
+
+        bool parseAnd()
+        {
+            if (!parseUnary())
+                return false;
+            while (accept('&'))
+            {
+                if (!parseUnary() || !emit(AND))
+                    return false;
+            }
+            return true;
+        }
+
+        bool parseUnary()
+        {
+            if (accept('!') || accept('~'))
+            {
+                return parseUnary() && emit(NOT);
+            }
+            return parsePrimary();
+        }
+
+        bool parsePrimary()
+        {
+            skipSpace();
+            if (accept('('))
+            {
+                return parseOr() && accept(')');
+            }
+            if (*p == '0' || *p == '1')
+            {
+                uint16_t value = *p++ - '0';
+                skipSpace();
+                return emit(CONST, value);
+            }
+            if (*p == 'b' || *p == 'B')
+            {
+                p++;
+                if (*p < '0' || *p > '9')
+                    return fail();
+                int bit = 0;
+                while (*p >= '0' && *p <= '9')
+                {
+                    bit = bit * 10 + (*p++ - '0');
+                    if (bit > 15)
+                        return fail();
+                }
+                skipSpace();
+                return emit(PUSH, (uint16_t)(1 << bit));
+            }
+            return fail();
+        }
+    };
+};
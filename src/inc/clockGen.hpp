@@ -0,0 +1,153 @@
+/*
+ * Description:
+ * clockGen Internal clock source with multiplication, division and phase-locked tracking.
+ *
+ * Modes:
+ * - external: passes the incoming clock edges straight through.
+ * - internal: free-running clock at a given BPM, scaled by the ratio.
+ * - pll: measures the period of the incoming clock in samples and emits multiplied or divided
+ *   edges locked to it. Multiplied edges are placed on exact sample positions inside each
+ *   measured period, and every incoming edge re-syncs the phase, so ratchets never drift.
+ */
+
+#pragma once
+
+#include "plugin.hpp"
+
+struct ClockGen
+{
+    enum Mode
+    {
+        EXTERNAL,
+        INTERNAL,
+        PLL,
+        NUM_MODES
+    };
+
+    /// Clock ratios selectable by param and CV. Negative values divide, positive values multiply.
+    static constexpr int RATIO_COUNT = 11;
+    static constexpr int RATIOS[RATIO_COUNT] = {-8, -6, -4, -3, -2, 1, 2, 3, 4, 6, 8};
+    static constexpr int RATIO_DEFAULT = 5;
+
+    /// Labels for RATIOS, in the same order.
+    static std::vector<std::string> ratioLabels()
+    {
+        return {"/8", "/6", "/4", "/3", "/2", "x1", "x2", "x3", "x4", "x6", "x8"};
+    }
+
+    /// Level of the generated clock. High for the first half of each output period.
+    bool gate = false;
+
+    /// Free-running phase for internal mode, 0-1.
+    double phase = 0.0;
+
+    /// Samples since the last incoming edge.
+    uint32_t since_edge = 0;
+    /// Whether an incoming edge has been seen since the last reset.
+    bool seen_edge = false;
+    /// Measured incoming period in samples, 0 until two edges have been seen.
+    uint32_t period = 0;
+    /// Next sub-edge to emit within the current incoming period when multiplying.
+    int sub_edge = 0;
+    /// Incoming edges counted towards the next divided edge.
+    int div_count = 0;
+    /// Samples since the last emitted edge, and the gate length for the current output period.
+    uint32_t since_out = 0;
+    uint32_t gate_len = 0;
+
+    void reset()
+    {
+        gate = false;
+        phase = 0.0;
+        since_edge = 0;
+        seen_edge = false;
+        period = 0;
+        sub_edge = 0;
+        div_count = 0;
+        since_out = 0;
+        gate_len = 0;
+    }
+
+    /**
+     * Advances the clock by one sample and returns true if an output edge occurs on this sample.
+     *
+     * `ext_edge` is the rising edge of the incoming clock, `ext_high` its current level.
+     */
+    bool process(int mode, float bpm, int ratio_index, bool ext_edge, bool ext_high, float sample_time)
+    {
+        int ratio = RATIOS[clamp(ratio_index, 0, RATIO_COUNT - 1)];
+        switch (mode)
+        {
+        case INTERNAL:
+            return processInternal(bpm, ratio, sample_time);
+        case PLL:
+            return processPLL(ratio, ext_edge, sample_time);
+        default:
+            gate = ext_high;
+            return ext_edge;
+        }
+    }
+
+private:
+    bool processInternal(float bpm, int ratio, float sample_time)
+    {
+        double rate = bpm / 60.0 * (ratio > 0 ? ratio : 1.0 / -ratio);
+        phase += rate * sample_time;
+        bool edge = phase >= 1.0;
+        if (edge)
+        {
+            phase -= std::floor(phase);
+        }
+        gate = phase < 0.5;
+        return edge;
+    }
+
+    bool processPLL(int ratio, bool ext_edge, float sample_time)
+    {
+        bool edge = false;
+        // saturate instead of wrapping when the incoming clock stops
+        if (since_edge < UINT32_MAX)
+            since_edge++;
+        if (since_out < UINT32_MAX)
+            since_out++;
+
+        if (ext_edge)
+        {
+            if (seen_edge)
+            {
+                period = since_edge;
+            }
+            seen_edge = true;
+            since_edge = 0;
+            sub_edge = 1;
+            if (ratio > 0 || div_count == 0)
+            {
+                edge = true;
+                uint32_t out_period = ratio > 0 ? period / ratio : period * -ratio;
+                // 10ms gates until the incoming period is known
+                gate_len = period > 0 ? std::max(out_period / 2, 1u) : (uint32_t)(0.01f / sample_time);
+            }
+            if (ratio < 0)
+            {
+                div_count = (div_count + 1) % -ratio;
+            }
+        }
+        else if (ratio > 1 && period > 0 && sub_edge < ratio)
+        {
+            // place the k-th multiplied edge on the sample nearest to k/ratio of the measured period
+            uint32_t at = (uint32_t)(((uint64_t)period * sub_edge + ratio / 2) / ratio);
+            if (since_edge >= at)
+            {
+                edge = true;
+                sub_edge++;
+            }
+        }
+
+        if (edge)
+        {
+            since_out = 0;
+        }
+        gate = since_out < gate_len;
+        return edge;
+    }
+};
@@ -0,0 +1,151 @@
+/*
+ * Description:
+ * patternLibrary Tables of tape patterns, generated at compile time.
+ *
+ * - euclidean: k onsets spread as evenly as possible over n steps, for every n from 1 to 16 and
+ *   k from 0 to n (152 patterns, ordered by n then k). patterns shorter than the tape repeat to
+ *   fill it.
+ * - necklaces: every 16 bit pattern that is the smallest of its rotations, i.e. one pattern per
+ *   class of tapes the shift can turn into each other (4116 patterns, in lexicographic order).
+ *
+ * Step i of a pattern is tape bit i, so bit 0 plays first and the shift walks through the rest.
+ * Loading a pattern on the audio thread is a single table read.
+ */
+
+#pragma once
+
+#include "plugin.hpp"
+#include <array>
+
+namespace patterns
+{
+    static constexpr int WIDTH = 16;
+
+    static constexpr int EUCLIDEAN_COUNT = WIDTH * (WIDTH + 3) / 2;
+
+    /// Euclidean rhythm E(k, n) over n steps, repeated to fill the tape.
+    constexpr uint16_t euclidean(int n, int k)
+    {
+        uint16_t tape = 0;
+        for (int i = 0; i < WIDTH; i++)
+        {
+            int step = i % n;
+            if ((step * k) % n < k)
+                tape |= 1 << i;
+        }
+        return tape;
+    }
+
+    constexpr std::array<uint16_t, EUCLIDEAN_COUNT> buildEuclidean()
+    {
+        std::array<uint16_t, EUCLIDEAN_COUNT> table{};
+        int index = 0;
+        for (int n = 1; n <= WIDTH; n++)
+            for (int k = 0; k <= n; k++)
+                table[index++] = euclidean(n, k);
+        return table;
+    }
+
+    /**
+     * Runs `out` on every binary necklace of WIDTH bits in lexicographic order, as `a[1..WIDTH]`.
+     *
+     * Iterative Fredricksen-Kessler-Maiorana: steps through the prenecklaces and keeps those whose period divides the width.
+     */
+    template <typename F>
+    constexpr void forEachNecklace(F out)
+    {
+        int a[WIDTH + 1] = {};
+        out(a);
+        while (true)
+        {
+            int i = WIDTH;
+            while (i > 0 && a[i] == 1)
+                i--;
+            if (i == 0)
+                return;
+            a[i] = 1;
+            for (int j = i + 1; j <= WIDTH; j++)
+                a[j] = a[j - i];
+            if (WIDTH % i == 0)
+                out(a);
+        }
+    }
+
+    constexpr int countNecklaces()
+    {
+        int count = 0;
+        forEachNecklace([&](const int *)
+                        { count++; });
+        return count;
+    }
+
+    static constexpr int NECKLACE_COUNT = countNecklaces();
+
+    constexpr std::array<uint16_t, NECKLACE_COUNT> buildNecklaces()
+    {
+        std::array<uint16_t, NECKLACE_COUNT> table{};
+        int index = 0;
+        forEachNecklace([&](const int *a)
+                        {
+            uint16_t tape = 0;
+            for (int s = 0; s < WIDTH; s++)
+                tape |= a[s + 1] << s;
+            table[index++] = tape; });
+        return table;
+    }
+}
+
+struct PatternLibrary
+{
+    enum Bank
+    {
+        EUCLIDEAN,
+        NECKLACES,
+        NUM_BANKS
+    };
+
+    static std::vector<std::string> bankLabels()
+    {
+        return {"euclidean", "necklaces"};
+    }
+
+    static constexpr std::array<uint16_t, patterns::EUCLIDEAN_COUNT> EUCLIDEAN_TABLE = patterns::buildEuclidean();
+    static constexpr std::array<uint16_t, patterns::NECKLACE_COUNT> NECKLACE_TABLE = patterns::buildNecklaces();
+
+    static int count(int bank)
+    {
+        return bank == NECKLACES ? patterns::NECKLACE_COUNT : patterns::EUCLIDEAN_COUNT;
+    }
+
+    /// Pattern index for a selector position of 0-1.
+    static int index(int bank, float position)
+    {
+        return (int)std::round(clamp(position, 0.f, 1.f) * (count(bank) - 1));
+    }
+
+    static uint16_t get(int bank, int index)
+    {
+        return bank == NECKLACES ? NECKLACE_TABLE[index] : EUCLIDEAN_TABLE[index];
+    }
+
+    /// Display name, e.g. `E(3,8)` or `necklace 12: 0x0107`.
+    static std::string name(int bank, int index)
+    {
+        if (bank == NECKLACES)
+        {
+            return string::f("necklace %d: 0x%04x", index + 1, NECKLACE_TABLE[index]);
+        }
+        int n = 1;
+        while (index > n)
+        {
+            index -= n + 1;
+            n++;
+        }
+        return string::f("E(%d,%d)", index, n);
+    }
+};
+
+static_assert(patterns::NECKLACE_COUNT == 4116, "binary necklaces of length 16");
+static_assert(patterns::EUCLIDEAN_COUNT == 152, "n 1-16, k 0-n");
+static_assert(patterns::euclidean(8, 3) == 0x4949, "tresillo x..x..x. from bit 0, repeated");
+static_assert(PatternLibrary::NECKLACE_TABLE[1] == 0x8000, "second necklace has its only set bit last");
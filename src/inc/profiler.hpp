@@ -0,0 +1,277 @@
+/*
+ * Description:
+ * profiler Optional hot-path instrumentation for module process() calls.
+ *
+ * Compiled out unless the plugin is built with `make PROFILE=1` (defines TURINGSBITS_PROFILE).
+ *
+ * Each instance keeps lock-free cycle histograms for clock edge and non-edge samples, plus a ring
+ * of recent edge samples and spikes tagged with the active modes. The audio thread is the only
+ * writer. The UI thread reads percentiles from the histograms and can dump a Chrome trace
+ * (chrome://tracing, Perfetto) of the ring to disk, written from a background thread.
+ *
+ * `benchmarkPatchLoad` times what opening a patch costs per instance: constructing the module,
+ * restoring its saved state and constructing its panel.
+ */
+
+#pragma once
+
+#include "plugin.hpp"
+
+#ifdef TURINGSBITS_PROFILE
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <thread>
+#if defined ARCH_X64
+#include <x86intrin.h>
+#endif
+
+/// Timestamp in CPU cycles where available, steady clock nanoseconds otherwise.
+inline uint64_t cycleCount()
+{
+#if defined ARCH_X64
+    return __rdtsc();
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+/**
+ * Histogram of cycle counts with four buckets per octave (about 19% resolution).
+ *
+ * Single writer, any number of readers. Counts are relaxed atomics, so a reader may see a sample in one bucket but not yet the total.
+ */
+struct CycleHistogram
+{
+    static constexpr int SUB_BUCKETS = 4;
+    static constexpr int BUCKETS = 64 * SUB_BUCKETS;
+
+    std::atomic<uint32_t> counts[BUCKETS] = {};
+    std::atomic<uint64_t> total{0};
+
+    static int bucket(uint64_t cycles)
+    {
+        if (cycles < SUB_BUCKETS)
+            return (int)cycles;
+        int octave = 63 - __builtin_clzll(cycles);
+        int sub = (int)(cycles >> (octave - 2)) & (SUB_BUCKETS - 1);
+        return octave * SUB_BUCKETS + sub;
+    }
+
+    /// Lower bound, in cycles, of the values counted in `b`.
+    static uint64_t bucketFloor(int b)
+    {
+        if (b < 2 * SUB_BUCKETS)
+            return std::min(b, SUB_BUCKETS);
+        int octave = b / SUB_BUCKETS;
+        return ((uint64_t)(SUB_BUCKETS + b % SUB_BUCKETS)) << (octave - 2);
+    }
+
+    /// Only called from the audio thread, so a load and a store are enough.
+    void record(uint64_t cycles)
+    {
+        std::atomic<uint32_t> &c = counts[bucket(cycles)];
+        c.store(c.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        total.store(total.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    /// Approximate `q` quantile (0-1) in cycles, 0 if nothing has been recorded.
+    uint64_t percentile(float q)
+    {
+        uint64_t n = total.load(std::memory_order_relaxed);
+        if (n == 0)
+            return 0;
+        uint64_t target = (uint64_t)(q * n);
+        uint64_t seen = 0;
+        for (int b = 0; b < BUCKETS; b++)
+        {
+            seen += counts[b].load(std::memory_order_relaxed);
+            if (seen > target)
+                return bucketFloor(b);
+        }
+        return bucketFloor(BUCKETS - 1);
+    }
+
+    void reset()
+    {
+        for (int b = 0; b < BUCKETS; b++)
+            counts[b].store(0, std::memory_order_relaxed);
+        total.store(0, std::memory_order_relaxed);
+    }
+};
+
+struct ProcessProfiler
+{
+    /// One traced process() call. `tags` is a module-defined bitfield describing the active modes.
+    struct Event
+    {
+        uint64_t start;
+        uint32_t cycles;
+        bool edge;
+        uint32_t tags;
+    };
+
+    static constexpr int RING_SIZE = 4096;
+
+    CycleHistogram edge_hist;
+    CycleHistogram other_hist;
+
+    Event ring[RING_SIZE];
+    std::atomic<uint32_t> ring_head{0};
+
+    /// Running average of non-edge samples. Non-edge samples slower than 4x this are traced as spikes.
+    float other_avg = 0.f;
+
+    void record(uint64_t start, uint64_t cycles, bool edge, uint32_t tags)
+    {
+        bool trace = edge;
+        if (edge)
+        {
+            edge_hist.record(cycles);
+        }
+        else
+        {
+            other_hist.record(cycles);
+            trace = other_avg > 0.f && cycles > 4.f * other_avg;
+            other_avg += (cycles - other_avg) * (1.f / 1024.f);
+        }
+        if (trace)
+        {
+            uint32_t head = ring_head.load(std::memory_order_relaxed);
+            ring[head % RING_SIZE] = {start, (uint32_t)std::min<uint64_t>(cycles, UINT32_MAX), edge, tags};
+            ring_head.store(head + 1, std::memory_order_release);
+        }
+    }
+
+    void reset()
+    {
+        edge_hist.reset();
+        other_hist.reset();
+        other_avg = 0.f;
+    }
+
+    /// Copies the traced events, oldest first. Events overwritten during the copy may be torn, which is acceptable for diagnostics.
+    std::vector<Event> snapshot()
+    {
+        uint32_t head = ring_head.load(std::memory_order_acquire);
+        uint32_t count = std::min<uint32_t>(head, RING_SIZE);
+        std::vector<Event> events;
+        events.reserve(count);
+        for (uint32_t i = head - count; i != head; i++)
+        {
+            events.push_back(ring[i % RING_SIZE]);
+        }
+        return events;
+    }
+
+    /**
+     * Writes the traced events to `path` as a Chrome trace on a background thread.
+     *
+     * `describe` turns an event's tags into JSON args, e.g. `"mode":"trigger"`. It runs on the calling thread, so it may safely use the module.
+     */
+    void dump(const std::string &path, const std::string &name, std::function<std::string(uint32_t)> describe)
+    {
+        std::vector<Event> events = snapshot();
+        std::vector<std::string> args;
+        args.reserve(events.size());
+        for (const Event &e : events)
+        {
+            args.push_back(describe(e.tags));
+        }
+        uint64_t edge_p50 = edge_hist.percentile(0.5f), edge_p99 = edge_hist.percentile(0.99f);
+        uint64_t other_p50 = other_hist.percentile(0.5f), other_p99 = other_hist.percentile(0.99f);
+        std::thread([=]()
+                    {
+            double per_us = ticksPerMicrosecond();
+            uint64_t origin = events.empty() ? 0 : events.front().start;
+            std::ofstream out(path);
+            out << "{\"otherData\":{\"name\":\"" << name << "\""
+                << ",\"edge_p50_cycles\":" << edge_p50 << ",\"edge_p99_cycles\":" << edge_p99
+                << ",\"other_p50_cycles\":" << other_p50 << ",\"other_p99_cycles\":" << other_p99
+                << ",\"ticks_per_us\":" << per_us << "},\"traceEvents\":[";
+            for (size_t i = 0; i < events.size(); i++)
+            {
+                const Event &e = events[i];
+                out << (i ? "," : "") << "{\"name\":\"" << (e.edge ? "edge" : "spike") << "\",\"ph\":\"X\",\"pid\":1,\"tid\":\"" << name << "\""
+                    << ",\"ts\":" << (e.start - origin) / per_us << ",\"dur\":" << e.cycles / per_us
+                    << ",\"args\":{\"cycles\":" << e.cycles << "," << args[i] << "}}";
+            }
+            out << "]}";
+            INFO("profile written to %s", path.c_str()); })
+            .detach();
+    }
+
+private:
+    static double ticksPerMicrosecond()
+    {
+#if defined ARCH_X64
+        auto t0 = std::chrono::steady_clock::now();
+        uint64_t c0 = cycleCount();
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        uint64_t c1 = cycleCount();
+        auto t1 = std::chrono::steady_clock::now();
+        return (c1 - c0) / (double)std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0).count();
+#else
+        return 1000.0;
+#endif
+    }
+};
+
+/// Mean milliseconds per instance of each step of a patch load, and the slowest whole instance.
+struct PatchLoadTimes
+{
+    double module_ms = 0.0;
+    double json_ms = 0.0;
+    double panel_ms = 0.0;
+    double worst_ms = 0.0;
+};
+
+/**
+ * Loads `n` instances as opening a patch does: constructs each module, restores `state` into it with dataFromJson and
+ * constructs its panel, timing each step, then deletes them all.
+ *
+ * UI thread only. The modules are never added to the engine.
+ */
+template <class TModule, class TWidget>
+PatchLoadTimes benchmarkPatchLoad(int n, json_t *state)
+{
+    using clock = std::chrono::steady_clock;
+    auto ms = [](clock::time_point from, clock::time_point to)
+    { return std::chrono::duration<double, std::milli>(to - from).count(); };
+
+    PatchLoadTimes times;
+    std::vector<std::pair<TModule *, TWidget *>> loaded;
+    loaded.reserve(n);
+    for (int i = 0; i < n; i++)
+    {
+        auto start = clock::now();
+        TModule *module = new TModule;
+        auto constructed = clock::now();
+        module->dataFromJson(state);
+        auto restored = clock::now();
+        TWidget *widget = new TWidget(module);
+        auto done = clock::now();
+        times.module_ms += ms(start, constructed);
+        times.json_ms += ms(constructed, restored);
+        times.panel_ms += ms(restored, done);
+        times.worst_ms = std::max(times.worst_ms, ms(start, done));
+        loaded.push_back({module, widget});
+    }
+    for (auto &[module, widget] : loaded)
+    {
+        // the engine owns modules in a real patch, so the widget is detached before either is deleted
+        widget->module = nullptr;
+        delete widget;
+        delete module;
+    }
+    if (n > 0)
+    {
+        times.module_ms /= n;
+        times.json_ms /= n;
+        times.panel_ms /= n;
+    }
+    return times;
+}
+
+#endif
@@ -0,0 +1,139 @@
+/*
+ * Description:
+ * tapeGroup Plugin-wide groups of tape machines sharing one clock and one random source.
+ *
+ * Members join a group and get the lowest free index. The lowest taken index leads, so when
+ * the leader leaves the next member takes over on the following frame. The leader runs its own
+ * clock and, every frame, publishes whether that frame had an edge, the clock gate, whether it
+ * has a clock source at all, (on edges) one random word per member index, and finally its tape
+ * once it has stepped. The leader steps on its own edge; followers step on the slot published
+ * the frame before, so they all move together one frame later whatever order the engine
+ * processes modules in, and the leader's tape they read is the one that edge produced.
+ * Followers skip their own edge detection and random draws.
+ *
+ * Slots are double buffered by frame parity. The engine finishes every module's frame before
+ * starting the next, so the slot a member reads is never the one being written. Publishing
+ * claims the slot first, so if membership changes mid-frame and two members both think they
+ * lead, only one of them writes it. The frame stamp also tells a live leader from a stale one.
+ */
+
+#pragma once
+
+#include "plugin.hpp"
+#include <atomic>
+
+struct TapeGroup
+{
+    static constexpr int GROUPS = 4;
+    static constexpr int MEMBERS = 16;
+
+    struct Slot
+    {
+        /// Frame the slot was published for, WRITING while it is being written.
+        std::atomic<int64_t> frame{-1};
+        bool edge = false;
+        float gate = 0.f;
+        /// Leader has a clock cable or runs an internal clock.
+        bool clocked = false;
+        /// Leader's tape after the frame's step.
+        uint16_t tape = 0;
+        uint32_t words[MEMBERS] = {};
+    };
+
+    static constexpr int64_t WRITING = -2;
+
+    Slot slots[2];
+
+    /// Bit i is set while member index i is taken.
+    std::atomic<uint32_t> members{0};
+
+    static TapeGroup &get(int group)
+    {
+        static TapeGroup groups[GROUPS];
+        return groups[group];
+    }
+
+    static std::vector<std::string> groupLabels()
+    {
+        return {"none", "a", "b", "c", "d"};
+    }
+
+    /// Claims the lowest free member index. Returns -1 if the group is full.
+    int join()
+    {
+        uint32_t taken = members.load();
+        while (true)
+        {
+            if (taken == (1u << MEMBERS) - 1)
+                return -1;
+            int index = __builtin_ctz(~taken);
+            if (members.compare_exchange_weak(taken, taken | (1u << index)))
+                return index;
+        }
+    }
+
+    void leave(int index)
+    {
+        members.fetch_and(~(1u << index));
+    }
+
+    /// Whether member `index` is the lowest taken index, i.e. the one that should publish.
+    bool leads(int index) const
+    {
+        uint32_t taken = members.load(std::memory_order_relaxed);
+        return taken && __builtin_ctz(taken) == index;
+    }
+
+    /**
+     * Leader only, once per frame, before stepping. Claims the frame's slot and fills in the clock and random words.
+     *
+     * Returns false, writing nothing, if another member already claimed this frame. Otherwise the leader must call
+     * finishPublish() for the same frame once it has stepped.
+     */
+    bool beginPublish(int64_t frame, bool edge, float gate, bool clocked)
+    {
+        Slot &slot = slots[frame & 1];
+        int64_t seen = slot.frame.load(std::memory_order_relaxed);
+        if (seen >= frame || seen == WRITING || !slot.frame.compare_exchange_strong(seen, WRITING, std::memory_order_acquire))
+            return false;
+        slot.edge = edge;
+        slot.gate = gate;
+        slot.clocked = clocked;
+        if (edge)
+        {
+            for (int i = 0; i < MEMBERS; i++)
+            {
+                slot.words[i] = random::u32();
+            }
+        }
+        return true;
+    }
+
+    /// Random word at `index` of the slot the leader is publishing for `frame`.
+    uint32_t word(int64_t frame, int index) const
+    {
+        return slots[frame & 1].words[index];
+    }
+
+    /// Leader only: adds the stepped tape and releases the slot to the followers.
+    void finishPublish(int64_t frame, uint16_t tape)
+    {
+        Slot &slot = slots[frame & 1];
+        slot.tape = tape;
+        slot.frame.store(frame, std::memory_order_release);
+    }
+
+    /// Reads the slot published for `frame` and the random word at `index`. Returns false if no leader published that frame.
+    bool read(int64_t frame, int index, bool &edge, float &gate, bool &clocked, uint32_t &word, uint16_t &tape)
+    {
+        const Slot &slot = slots[frame & 1];
+        if (frame < 0 || slot.frame.load(std::memory_order_acquire) != frame)
+            return false;
+        edge = slot.edge;
+        gate = slot.gate;
+        clocked = slot.clocked;
+        word = slot.words[index];
+        tape = slot.tape;
+        return true;
+    }
+};
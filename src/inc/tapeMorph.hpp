@@ -0,0 +1,62 @@
+/*
+ * Description:
+ * tapeMorph Bitwise crossfade from a tape toward a target state.
+ *
+ * A morph amount between 0 and 1 picks how many of the bits that differ between the tape and
+ * the target are flipped, always starting from the lowest differing bit, so every amount maps
+ * to exactly one state and sweeping it walks the same path each time. The lowest k differing
+ * bits are found with a binary search on the popcount of the low bits of the xor: a handful of
+ * masks and popcounts whatever the tape width, with no loop over bits.
+ */
+
+#pragma once
+
+#include "plugin.hpp"
+#include <bit>
+#include <limits>
+
+template <typename T>
+struct TapeMorph
+{
+    static constexpr int BITS = std::numeric_limits<T>::digits;
+
+    /// Mask of the lowest `m` bits.
+    static constexpr T lowMask(int m)
+    {
+        return m >= BITS ? (T)~T(0) : (T)((T(1) << m) - 1);
+    }
+
+    /// The lowest `k` set bits of `x`, all of them if it has fewer.
+    static constexpr T lowestSetBits(T x, int k)
+    {
+        if (k <= 0)
+            return 0;
+        // smallest m whose low m bits of x hold k set bits
+        int lo = 0, hi = BITS;
+        while (lo < hi)
+        {
+            int mid = (lo + hi) / 2;
+            if (std::popcount((T)(x & lowMask(mid))) >= k)
+                hi = mid;
+            else
+                lo = mid + 1;
+        }
+        return x & lowMask(lo);
+    }
+
+    /// How many differing bits an `amount` (0-1) of the way from `tape` to `target` flips.
+    static int steps(T tape, T target, float amount)
+    {
+        return (int)std::round(clamp(amount, 0.f, 1.f) * std::popcount((T)(tape ^ target)));
+    }
+
+    /// `tape` with its lowest `steps(tape, target, amount)` differing bits taken from `target`.
+    static T view(T tape, T target, float amount)
+    {
+        return tape ^ lowestSetBits(tape ^ target, steps(tape, target, amount));
+    }
+};
+
+static_assert(TapeMorph<uint16_t>::lowestSetBits(0b1011010, 2) == 0b0000010 + 0b0001000, "lowest bits first");
+static_assert(TapeMorph<uint16_t>::lowestSetBits(0b1011010, 9) == 0b1011010, "all bits when k exceeds the count");
+static_assert(TapeMorph<uint16_t>::lowestSetBits(0x8000, 1) == 0x8000, "top bit");
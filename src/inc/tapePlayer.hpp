@@ -0,0 +1,361 @@
+/*
+ * Description:
+ * tapePlayer Memory-mapped playback of recorded tape files.
+ *
+ * A tape file is a flat sequence of 16 bit little-endian tape values, one value per clock step.
+ * The file is memory-mapped read-only, and a worker thread pages the mapping in ahead of the
+ * read position and publishes the range it has paged in. The audio thread only reads inside
+ * that range: a position the worker has not reached yet (e.g. after a scrub) reads as not ready
+ * instead of faulting the page in from disk. Pages well behind the read position are handed back
+ * to the OS, so multi-hour files keep a small resident footprint.
+ *
+ * The worker only runs while a file is loaded. It is stopped and joined before any mapping is
+ * unmapped, so it never touches a mapping that is going away.
+ *
+ * Usage:
+ * 1. Add a `TapePlayer player` to your Module.
+ * 2. Call `player.open(path)` / `player.close()` from the UI thread (menu actions, dataFromJson).
+ * 3. In your process call, call `player.read(index, value)` and publish the read position with `player.seek(index)`.
+ */
+
+#pragma once
+
+#include "plugin.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#if defined ARCH_WIN
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+struct TapePlayer
+{
+    /// Number of frames paged in ahead of the read position by the worker thread (1 MiB).
+    static constexpr size_t LOOKAHEAD_FRAMES = 1 << 19;
+
+    /// Granularity used when touching pages. Smaller than or equal to every page size we run on.
+    static constexpr size_t PAGE_BYTES = 4096;
+
+    /// Frames the worker pages in between publishing progress (64 KiB).
+    static constexpr size_t CHUNK_FRAMES = 1 << 15;
+
+    /**
+     * A single read-only mapping of a tape file.
+     *
+     * Mappings are created and destroyed on the UI thread only. The audio thread sees them through `TapePlayer::current`.
+     */
+    struct Mapping
+    {
+        const uint16_t *frames = nullptr;
+        size_t length = 0;
+        size_t bytes = 0;
+        std::string path;
+
+        /// Frames [from, to) paged in by the worker, packed as from << 32 | to so both ends are published together.
+        std::atomic<uint64_t> resident_range{0};
+        /// Frames [0, wrap_to) have also been paged in, for looping back to the start.
+        std::atomic<size_t> wrap_to{0};
+#if defined ARCH_WIN
+        HANDLE file = INVALID_HANDLE_VALUE;
+        HANDLE mapping = NULL;
+#else
+        int fd = -1;
+#endif
+
+        /// Maps the file at `path`. Returns false, leaving the Mapping empty, if the file cannot be mapped or holds no frames.
+        bool open(const std::string &path)
+        {
+            this->path = path;
+#if defined ARCH_WIN
+            file = CreateFileW(string::UTF8toUTF16(path).c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+            if (file == INVALID_HANDLE_VALUE)
+                return false;
+            LARGE_INTEGER size;
+            if (!GetFileSizeEx(file, &size))
+                return false;
+            bytes = (size_t)size.QuadPart;
+            if (bytes < sizeof(uint16_t))
+                return false;
+            mapping = CreateFileMappingW(file, NULL, PAGE_READONLY, 0, 0, NULL);
+            if (!mapping)
+                return false;
+            frames = (const uint16_t *)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+            if (!frames)
+                return false;
+#else
+            fd = ::open(path.c_str(), O_RDONLY);
+            if (fd < 0)
+                return false;
+            struct stat st;
+            if (fstat(fd, &st) != 0)
+                return false;
+            bytes = (size_t)st.st_size;
+            if (bytes < sizeof(uint16_t))
+                return false;
+            void *addr = mmap(NULL, bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (addr == MAP_FAILED)
+                return false;
+            frames = (const uint16_t *)addr;
+            madvise(addr, bytes, MADV_SEQUENTIAL);
+#endif
+            // resident ranges are packed in 32 bits per end: play at most the first 4G frames (8 GiB)
+            length = std::min<size_t>(bytes / sizeof(uint16_t), UINT32_MAX);
+            return true;
+        }
+
+        ~Mapping()
+        {
+#if defined ARCH_WIN
+            if (frames)
+                UnmapViewOfFile(frames);
+            if (mapping)
+                CloseHandle(mapping);
+            if (file != INVALID_HANDLE_VALUE)
+                CloseHandle(file);
+#else
+            if (frames)
+                munmap((void *)frames, bytes);
+            if (fd >= 0)
+                ::close(fd);
+#endif
+        }
+
+        /// Faults in the pages backing frames [from, to).
+        void pageIn(size_t from, size_t to) const
+        {
+            const volatile uint8_t *base = (const volatile uint8_t *)frames;
+            size_t end = std::min(to * sizeof(uint16_t), bytes);
+            for (size_t b = from * sizeof(uint16_t); b < end; b += PAGE_BYTES)
+            {
+                (void)base[b];
+            }
+        }
+
+        /// Publishes [from, to) as paged in. A reader sees either the old range or the new one, never a mix of both.
+        void setResident(size_t from, size_t to)
+        {
+            resident_range.store((uint64_t)from << 32 | to, std::memory_order_release);
+        }
+
+        bool resident(size_t index) const
+        {
+            uint64_t range = resident_range.load(std::memory_order_acquire);
+            return (index >= (range >> 32) && index < (range & UINT32_MAX)) || index < wrap_to.load(std::memory_order_acquire);
+        }
+
+        /// Hands the pages backing frames [from, to) back to the OS. They are re-read from the file if touched again.
+        void pageOut(size_t from, size_t to) const
+        {
+#if !defined ARCH_WIN
+            uintptr_t start = ((uintptr_t)frames + from * sizeof(uint16_t) + PAGE_BYTES - 1) & ~(uintptr_t)(PAGE_BYTES - 1);
+            uintptr_t end = ((uintptr_t)frames + std::min(to * sizeof(uint16_t), bytes)) & ~(uintptr_t)(PAGE_BYTES - 1);
+            if (end > start)
+                madvise((void *)start, end - start, MADV_DONTNEED);
+#endif
+        }
+    };
+
+    /// The mapping read by the audio thread. Null when no file is loaded.
+    std::atomic<Mapping *> current{nullptr};
+
+    /// The previously loaded mapping, kept alive for one more load so an in-flight audio read never touches unmapped memory.
+    Mapping *retired = nullptr;
+
+    /// Last read position published by the audio thread, consumed by the worker.
+    std::atomic<size_t> position{0};
+
+    std::atomic<bool> running{false};
+    std::thread worker;
+    std::mutex worker_mutex;
+    std::condition_variable worker_cv;
+
+    ~TapePlayer()
+    {
+        stop();
+        delete current.exchange(nullptr);
+        delete retired;
+    }
+
+    /**
+     * Loads the tape file at `path`, replacing any loaded file.
+     *
+     * Must be called from the UI thread. Returns false and keeps the previous file if the new one cannot be mapped.
+     */
+    bool open(const std::string &path)
+    {
+        Mapping *m = new Mapping;
+        if (!m->open(path))
+        {
+            WARN("tape machine: could not map tape file %s", path.c_str());
+            delete m;
+            return false;
+        }
+        m->pageIn(0, std::min(m->length, LOOKAHEAD_FRAMES));
+        m->setResident(0, std::min(m->length, LOOKAHEAD_FRAMES));
+        position.store(0, std::memory_order_relaxed);
+        swap(m);
+        return true;
+    }
+
+    /// Unloads the current tape file and stops the worker. Must be called from the UI thread.
+    void close()
+    {
+        swap(nullptr);
+    }
+
+    /// Path of the loaded file, or an empty string.
+    std::string path()
+    {
+        Mapping *m = current.load(std::memory_order_acquire);
+        return m ? m->path : "";
+    }
+
+    /// Number of frames in the loaded file, or 0.
+    size_t length()
+    {
+        Mapping *m = current.load(std::memory_order_acquire);
+        return m ? m->length : 0;
+    }
+
+    /// Publishes the audio thread's read position so the worker pages in ahead of it.
+    void seek(size_t index)
+    {
+        position.store(index, std::memory_order_relaxed);
+    }
+
+    /**
+     * Reads the frame at `index` into `value`.
+     *
+     * Safe to call from the audio thread. Returns false if no file is loaded, `index` is out of range, or the worker has not
+     * paged `index` in yet. Publish `index` with `seek` and try again on a later step.
+     */
+    bool read(size_t index, uint16_t &value)
+    {
+        Mapping *m = current.load(std::memory_order_acquire);
+        if (!m || index >= m->length || !m->resident(index))
+            return false;
+        value = m->frames[index];
+        return true;
+    }
+
+private:
+    void swap(Mapping *m)
+    {
+        // the worker may be paging either mapping: join it before anything is unmapped
+        stop();
+        Mapping *old = current.exchange(m, std::memory_order_acq_rel);
+        delete retired;
+        retired = old;
+        if (m)
+            start();
+    }
+
+    void start()
+    {
+        if (running.exchange(true))
+            return;
+        worker = std::thread([this]()
+                             { run(); });
+    }
+
+    void stop()
+    {
+        if (!running.exchange(false))
+            return;
+        worker_cv.notify_all();
+        worker.join();
+    }
+
+    /// Pages in [from, to) one chunk at a time, calling `publish(end)` after each chunk. Returns false if stopped part way.
+    template <typename F>
+    bool pageIn(const Mapping *m, size_t from, size_t to, F publish)
+    {
+        for (size_t chunk = from; chunk < to; chunk += CHUNK_FRAMES)
+        {
+            if (!running.load(std::memory_order_relaxed))
+                return false;
+            size_t end = std::min(chunk + CHUNK_FRAMES, to);
+            m->pageIn(chunk, end);
+            publish(end);
+        }
+        return true;
+    }
+
+    void run()
+    {
+        // the mapping cannot change while the worker runs: swap() stops the worker first
+        Mapping *m = current.load(std::memory_order_acquire);
+        uint64_t range = m->resident_range.load(std::memory_order_relaxed);
+        size_t paged_from = range >> 32;
+        size_t paged_to = range & UINT32_MAX;
+        std::unique_lock<std::mutex> lock(worker_mutex);
+        while (running.load())
+        {
+            worker_cv.wait_for(lock, std::chrono::milliseconds(5));
+            if (!running.load())
+                break;
+
+            size_t pos = std::min(position.load(std::memory_order_relaxed), m->length);
+            size_t ahead = std::min(pos + LOOKAHEAD_FRAMES, m->length);
+
+            // jumped outside the paged window: restart the window at the new position
+            if (pos < paged_from || pos > paged_to)
+            {
+                // the range is replaced in one store before anything is paged out, so it never covers a page that is not in
+                size_t wrap = m->wrap_to.load(std::memory_order_relaxed);
+                if (pos < wrap)
+                {
+                    // looped back into the pages already in at the start of the file
+                    m->setResident(0, wrap);
+                    m->wrap_to.store(0, std::memory_order_release);
+                    m->pageOut(std::max(paged_from, wrap), paged_to);
+                    paged_from = 0;
+                    paged_to = wrap;
+                }
+                else
+                {
+                    m->setResident(pos, pos);
+                    m->pageOut(paged_from, paged_to);
+                    paged_from = paged_to = pos;
+                }
+            }
+            if (ahead > paged_to)
+            {
+                bool done = pageIn(m, paged_to, ahead, [&](size_t end)
+                                   { m->setResident(paged_from, end);
+                                     paged_to = end; });
+                if (!done)
+                    break;
+            }
+            // for looping, page in the start of the file while playing its end
+            if (ahead == m->length && pos + LOOKAHEAD_FRAMES > m->length)
+            {
+                size_t wrap = std::min(pos + LOOKAHEAD_FRAMES - m->length, paged_from);
+                if (wrap > m->wrap_to.load(std::memory_order_relaxed) && !pageIn(m, m->wrap_to.load(std::memory_order_relaxed), wrap, [&](size_t end)
+                                                                                                   { m->wrap_to.store(end, std::memory_order_release); }))
+                    break;
+            }
+
+            // release everything more than one lookahead behind the read position
+            if (pos > LOOKAHEAD_FRAMES && pos - LOOKAHEAD_FRAMES > paged_from)
+            {
+                m->setResident(pos - LOOKAHEAD_FRAMES, paged_to);
+                m->pageOut(paged_from, pos - LOOKAHEAD_FRAMES);
+                paged_from = pos - LOOKAHEAD_FRAMES;
+            }
+        }
+    }
+};
@@ -0,0 +1,101 @@
+/*
+ * Description:
+ * tapeStats Running statistics of a 16 bit tape, updated once per clock.
+ *
+ * All statistics are derived from the xor of successive tape states, so a clock that leaves the
+ * tape unchanged costs nothing, and nothing is ever rescanned over the history window.
+ *
+ * - density: number of set bits.
+ * - longest run: longest run of consecutive set bits around the (circular) tape, so rotating the
+ *   tape never changes it.
+ * - transitions: number of 0/1 boundaries around the (circular) tape.
+ * - entropy: Shannon entropy, in bits, of the set/clear ratio over the last HISTORY tape states.
+ */
+
+#pragma once
+
+#include "plugin.hpp"
+#include <bit>
+
+struct TapeStats
+{
+    static constexpr int BITS = 16;
+
+    /// Number of tape states in the rolling entropy window.
+    static constexpr int HISTORY = 32;
+
+    /// Tape state the statistics were last computed for.
+    uint16_t last = 0;
+
+    int density = 0;
+    int longest_run = 0;
+    int transitions = 0;
+    float entropy = 0.f;
+
+    /// Ring buffer of the density of the last HISTORY tape states, and their running sum.
+    uint8_t history[HISTORY] = {};
+    int history_pos = 0;
+    int history_ones = 0;
+
+    /// Binary entropy for every possible count of set bits in the window.
+    float entropy_table[HISTORY * BITS + 1];
+
+    TapeStats()
+    {
+        for (int ones = 0; ones <= HISTORY * BITS; ones++)
+        {
+            float p = (float)ones / (HISTORY * BITS);
+            float h = 0.f;
+            if (p > 0.f && p < 1.f)
+            {
+                h = -p * std::log2(p) - (1.f - p) * std::log2(1.f - p);
+            }
+            entropy_table[ones] = h;
+        }
+        reset();
+    }
+
+    void reset()
+    {
+        last = 0;
+        density = 0;
+        longest_run = 0;
+        transitions = 0;
+        entropy = 0.f;
+        std::fill(std::begin(history), std::end(history), 0);
+        history_pos = 0;
+        history_ones = 0;
+    }
+
+    /// Folds the tape state for one clock into the statistics.
+    void step(uint16_t tape)
+    {
+        uint16_t changed = tape ^ last;
+        if (changed)
+        {
+            // ones gained minus ones lost
+            density += std::popcount((uint16_t)(changed & tape)) - std::popcount((uint16_t)(changed & last));
+            transitions = std::popcount((uint16_t)(tape ^ std::rotr(tape, 1)));
+            longest_run = longestRun(tape);
+            last = tape;
+        }
+
+        history_ones += density - history[history_pos];
+        history[history_pos] = density;
+        history_pos = (history_pos + 1) % HISTORY;
+        entropy = entropy_table[history_ones];
+    }
+
+    /// Length of the longest circular run of set bits. Each step shortens every run by one, wrapping around the tape.
+    static int longestRun(uint16_t x)
+    {
+        if (x == 0xffff)
+            return BITS;
+        int n = 0;
+        for (; x; n++)
+        {
+            x &= std::rotr(x, 1);
+        }
+        return n;
+    }
+};
@@ -0,0 +1,55 @@
+/*
+ * Description:
+ * tripleBuffer Lock-free hand-over of a value from one writer thread to one reader thread.
+ *
+ * Three copies of the value rotate between the writer, the reader and a shared back slot. The
+ * writer fills its own copy and swaps it into the back slot; the reader swaps the back slot for
+ * its own copy when the writer has published something newer. Each copy is only ever touched
+ * by the thread that owns it, so however fast the writer publishes it never writes the copy the
+ * reader is using, and neither side waits, allocates or frees.
+ */
+
+#pragma once
+
+#include <atomic>
+
+template <typename T>
+struct TripleBuffer
+{
+    T slots[3];
+
+    /// Writer side: the copy to fill before calling publish().
+    T &writeSlot()
+    {
+        return slots[write_index];
+    }
+
+    /// Writer side: hands the filled copy to the reader and takes back the older one.
+    void publish()
+    {
+        write_index = back.exchange(write_index | FRESH, std::memory_order_acq_rel) & ~FRESH;
+    }
+
+    /// Reader side: picks up the newest published copy, if there is one. Returns true if it changed.
+    bool update()
+    {
+        if (!(back.load(std::memory_order_relaxed) & FRESH))
+            return false;
+        read_index = back.exchange(read_index, std::memory_order_acq_rel) & ~FRESH;
+        return true;
+    }
+
+    /// Reader side: the copy picked up by the last update().
+    const T &read() const
+    {
+        return slots[read_index];
+    }
+
+private:
+    static constexpr int FRESH = 4;
+
+    /// Index of the back slot, with FRESH set while the reader has not picked it up.
+    std::atomic<int> back{1};
+    int write_index = 0;
+    int read_index = 2;
+};
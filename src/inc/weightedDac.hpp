@@ -0,0 +1,161 @@
+/*
+ * Description:
+ * weightedDac Multi-tap weighted DAC over the bits of a 16 bit tape.
+ *
+ * Each tap has its own weight per bit, like the "Volts" expander of the hardware Turing Machine.
+ * The weight matrix is stored one float_4 per bit, holding that bit's weight for all four taps,
+ * so evaluating every tap is a single 16 term vectorized dot product of the bit vector against
+ * the matrix. Results are cached until the tape or the weights change.
+ */
+
+#pragma once
+
+#include "plugin.hpp"
+
+struct WeightedDac
+{
+    static constexpr int TAPS = 4;
+    static constexpr int BITS = 16;
+
+    enum Preset
+    {
+        BINARY,
+        REVERSED,
+        EQUAL,
+        LOW_BYTE,
+        HIGH_BYTE,
+        RANDOM,
+        NUM_PRESETS
+    };
+
+    static std::vector<std::string> presetLabels()
+    {
+        return {"binary", "reversed binary", "equal", "low byte", "high byte", "random"};
+    }
+
+    /// weights[bit][tap]. Weights are 0-1 and are normalized by their sum per tap.
+    simd::float_4 weights[BITS];
+
+    /// 1 / sum of weights per tap, 0 for taps whose weights are all 0.
+    simd::float_4 inv_total;
+
+    /// Cached output of each tap, 0-1.
+    simd::float_4 values;
+
+    uint16_t last_tape = 0;
+
+    /// Set when the weights change, forces the next `update` to recompute.
+    bool dirty = true;
+
+    WeightedDac()
+    {
+        reset();
+    }
+
+    void reset()
+    {
+        setPreset(0, BINARY);
+        setPreset(1, REVERSED);
+        setPreset(2, EQUAL);
+        setPreset(3, LOW_BYTE);
+    }
+
+    float getWeight(int tap, int bit)
+    {
+        return weights[bit][tap];
+    }
+
+    void setWeight(int tap, int bit, float weight)
+    {
+        weights[bit][tap] = clamp(weight, 0.f, 1.f);
+        updateTotals();
+    }
+
+    void setPreset(int tap, int preset)
+    {
+        for (int bit = 0; bit < BITS; bit++)
+        {
+            float w = 0.f;
+            switch (preset)
+            {
+            case BINARY:
+                w = (float)(1 << bit) / (1 << (BITS - 1));
+                break;
+            case REVERSED:
+                w = (float)(1 << (BITS - 1 - bit)) / (1 << (BITS - 1));
+                break;
+            case EQUAL:
+                w = 1.f;
+                break;
+            case LOW_BYTE:
+                w = bit < 8 ? (float)(1 << bit) / (1 << 7) : 0.f;
+                break;
+            case HIGH_BYTE:
+                w = bit >= 8 ? (float)(1 << (bit - 8)) / (1 << 7) : 0.f;
+                break;
+            case RANDOM:
+                w = random::uniform();
+                break;
+            }
+            weights[bit][tap] = w;
+        }
+        updateTotals();
+    }
+
+    void updateTotals()
+    {
+        simd::float_4 total = 0.f;
+        for (int bit = 0; bit < BITS; bit++)
+        {
+            total += weights[bit];
+        }
+        for (int tap = 0; tap < TAPS; tap++)
+        {
+            inv_total[tap] = total[tap] > 0.f ? 1.f / total[tap] : 0.f;
+        }
+        dirty = true;
+    }
+
+    /// Recomputes every tap for `tape`, unless neither the tape nor the weights changed.
+    void update(uint16_t tape)
+    {
+        if (!dirty && tape == last_tape)
+            return;
+        simd::float_4 acc = 0.f;
+        for (int bit = 0; bit < BITS; bit++)
+        {
+            acc += weights[bit] * simd::float_4((float)((tape >> bit) & 1));
+        }
+        values = acc * inv_total;
+        last_tape = tape;
+        dirty = false;
+    }
+
+    json_t *dataToJson()
+    {
+        json_t *tapsJ = json_array();
+        for (int tap = 0; tap < TAPS; tap++)
+        {
+            json_t *weightsJ = json_array();
+            for (int bit = 0; bit < BITS; bit++)
+            {
+                json_array_append_new(weightsJ, json_real(weights[bit][tap]));
+            }
+            json_array_append_new(tapsJ, weightsJ);
+        }
+        return tapsJ;
+    }
+
+    void dataFromJson(json_t *tapsJ)
+    {
+        for (int tap = 0; tap < TAPS && tap < (int)json_array_size(tapsJ); tap++)
+        {
+            json_t *weightsJ = json_array_get(tapsJ, tap);
+            for (int bit = 0; bit < BITS && bit < (int)json_array_size(weightsJ); bit++)
+            {
+                weights[bit][tap] = clamp((float)json_number_value(json_array_get(weightsJ, bit)), 0.f, 1.f);
+            }
+        }
+        updateTotals();
+    }
+};
@@ -0,0 +1,59 @@
+/*
+ * Description:
+ * writeWindow Masks of the bits set/clear write to, for a tape of any unsigned integer width.
+ *
+ * The window is `width` bits long and starts `position` bits in from the head of the tape (the
+ * bit new values enter at: the top bit when shifting left-to-right, bit 0 when right-to-left),
+ * running away from the head and wrapping around the tape. Every mask is precomputed at compile
+ * time, so applying a window on a clock is one table load and one and/or.
+ */
+
+#pragma once
+
+#include "plugin.hpp"
+#include <array>
+#include <bit>
+#include <limits>
+
+template <typename T>
+struct WriteWindow
+{
+    static_assert(std::numeric_limits<T>::is_integer && !std::numeric_limits<T>::is_signed, "tape must be an unsigned integer");
+
+    static constexpr int BITS = std::numeric_limits<T>::digits;
+
+    /// Window mask built directly from its definition, used to fill the table.
+    static constexpr T build(bool rtl, int width, int position)
+    {
+        T run = width >= BITS ? (T)~T(0) : (T)((T(1) << width) - 1);
+        return rtl ? std::rotl(run, position) : std::rotr(run, position + width);
+    }
+
+    /// table[rtl][width][position], width 0 to BITS, position 0 to BITS - 1.
+    using Table = std::array<std::array<std::array<T, BITS>, BITS + 1>, 2>;
+
+    static constexpr Table buildTable()
+    {
+        Table table{};
+        for (int rtl = 0; rtl < 2; rtl++)
+            for (int width = 0; width <= BITS; width++)
+                for (int position = 0; position < BITS; position++)
+                    table[rtl][width][position] = build(rtl, width, position);
+        return table;
+    }
+
+    static constexpr Table table = buildTable();
+
+    /// Mask of the window. `width` is clamped to 0-BITS and `position` wraps around the tape.
+    static T mask(bool rtl, int width, int position)
+    {
+        width = std::min(std::max(width, 0), BITS);
+        position = ((position % BITS) + BITS) % BITS;
+        return table[rtl][width][position];
+    }
+};
+
+static_assert(WriteWindow<uint16_t>::build(false, 1, 0) == 0x8000, "left-to-right head is the top bit");
+static_assert(WriteWindow<uint16_t>::build(true, 1, 0) == 0x0001, "right-to-left head is bit 0");
+static_assert(WriteWindow<uint16_t>::build(false, 4, 14) == 0xc003, "windows wrap around the tape");
+static_assert(WriteWindow<uint16_t>::build(true, 16, 5) == 0xffff, "a full width window covers the tape");
@@ -7,6 +7,7 @@ extern Plugin *pluginInstance;
 
 // Declare each Model, defined in each module source file
 extern Model *modelTapemachine;
+extern Model *modelTapeBank;
 
 struct BitKnob : RoundBlackKnob
 {
@@ -0,0 +1,343 @@
+// Differential test of TapeMachineModule::process() against the baseline module it was optimized from.
+//
+// Both modules get the same fuzzed input stream and the same random stream, one block at a time,
+// and every compared output must match sample for sample, bit for bit. The baseline is the
+// original src/TapeMachine.cpp, copied verbatim into baseline/ and built in its own namespace.
+//
+// Set and clear only happen in "write" blocks, with a 1 bit left-to-right shift and a settle
+// period before the first gate. The baseline writes `masks[15 << i]` for every shifted bit, which
+// reads past the mask table for shifts above 1, and always writes the top bit where the current
+// write window writes bit 0 for right-to-left, so other settings have no baseline to compare to.
+//
+// usage: differential [seeds] [samples per seed]
+
+#include "TapeMachine.cpp"
+#include <chrono>
+#include <random>
+
+namespace baseline
+{
+#include "baseline/TapeMachine.cpp"
+}
+
+Plugin *pluginInstance;
+
+using Current = TapeMachineModule;
+using Baseline = baseline::TapeMachineModule;
+
+static_assert((int)Current::RANDOM_PULSE_OUTPUT == (int)Baseline::RANDOM_PULSE_OUTPUT, "shared outputs keep their ids");
+
+// outputs compared sample for sample
+static const int COMPARED[] = {
+    Current::VOLTAGE_OUTPUT,
+    Current::FLIPPED_OUTPUT,
+    Current::MIN_OUTPUT,
+    Current::MAX_OUTPUT,
+    Current::RANDOM_PULSE_OUTPUT,
+    Current::PULSE_OUTPUT + 0, Current::PULSE_OUTPUT + 1, Current::PULSE_OUTPUT + 2, Current::PULSE_OUTPUT + 3,
+    Current::PULSE_OUTPUT + 4, Current::PULSE_OUTPUT + 5, Current::PULSE_OUTPUT + 6, Current::PULSE_OUTPUT + 7,
+    Current::PULSE_OUTPUT + 8, Current::PULSE_OUTPUT + 9, Current::PULSE_OUTPUT + 10, Current::PULSE_OUTPUT + 11,
+    Current::PULSE_OUTPUT + 12, Current::PULSE_OUTPUT + 13, Current::PULSE_OUTPUT + 14, Current::PULSE_OUTPUT + 15};
+static const int COMPARED_COUNT = sizeof COMPARED / sizeof COMPARED[0];
+// the current module's clock output is checked against the clock fed in, after the compared outputs
+static const int RECORDED = COMPARED_COUNT + 1;
+
+static std::string outputName(int slot)
+{
+   if (slot == COMPARED_COUNT)
+      return "clock";
+   switch (COMPARED[slot])
+   {
+   case Current::VOLTAGE_OUTPUT:
+      return "voltage";
+   case Current::FLIPPED_OUTPUT:
+      return "flipped";
+   case Current::MIN_OUTPUT:
+      return "minimum";
+   case Current::MAX_OUTPUT:
+      return "maximum";
+   case Current::RANDOM_PULSE_OUTPUT:
+      return "random pulse";
+   default:
+      return "bit 2^" + std::to_string(COMPARED[slot] - Current::PULSE_OUTPUT);
+   }
+}
+
+// input voltages for one sample
+struct Frame
+{
+   float clock;
+   float shift;
+   float dir;
+   float set;
+   float clear;
+};
+
+// everything that stays fixed for a block
+struct Block
+{
+   bool write;
+   float prob;
+   float shift_param;
+   float dir_param;
+   float set_param;
+   float clear_param;
+   bool shift_connected;
+   bool dir_connected;
+   size_t bit_pulse_mode;
+   size_t random_pulse_mode;
+   std::vector<Frame> frames;
+};
+
+struct Generator
+{
+   std::mt19937_64 rng;
+   // clock state carries over between blocks so edges are not only at block starts
+   int clock_left = 1;
+   bool clock_high = false;
+   float shift_cv = 0.f;
+   float dir_cv = 0.f;
+   float set_cv = 0.f;
+   float clear_cv = 0.f;
+
+   explicit Generator(uint64_t seed) : rng(seed) {}
+
+   int below(int n)
+   {
+      return (int)(rng() % n);
+   }
+
+   float uniform(float a, float b)
+   {
+      return a + (b - a) * (rng() >> 40) * (1.f / (1 << 24));
+   }
+
+   bool chance(int one_in)
+   {
+      return below(one_in) == 0;
+   }
+
+   // 0 or 10V most of the time, with the odd value right on or between the thresholds
+   float gate(bool high)
+   {
+      switch (below(40))
+      {
+      case 0:
+         return 5.f;
+      case 1:
+         return uniform(0.f, 1.f);
+      default:
+         return high ? 10.f : 0.f;
+      }
+   }
+
+   float probability()
+   {
+      switch (below(6))
+      {
+      case 0:
+         return 0.f;
+      case 1:
+         return 1.f;
+      default:
+         return uniform(0.f, 1.f);
+      }
+   }
+
+   Block next(int length)
+   {
+      Block block;
+      block.write = chance(3);
+      block.prob = probability();
+      block.bit_pulse_mode = below(3);
+      block.random_pulse_mode = below(3);
+      if (block.write)
+      {
+         block.shift_param = 1.f;
+         block.dir_param = 0.f;
+         block.set_param = chance(8) ? 1.f : 0.f;
+         block.clear_param = chance(8) ? 1.f : 0.f;
+         block.shift_connected = chance(2);
+         block.dir_connected = chance(2);
+         shift_cv = uniform(0.7f, 1.3f);
+         dir_cv = 0.f;
+      }
+      else
+      {
+         block.shift_param = 1 + below(15);
+         block.dir_param = below(2);
+         block.set_param = 0.f;
+         block.clear_param = 0.f;
+         block.shift_connected = chance(2);
+         block.dir_connected = chance(2);
+         set_cv = 0.f;
+         clear_cv = 0.f;
+      }
+      if (block.write)
+      {
+         length = std::max(length, SETTLE * 2);
+      }
+      int clock_period = 2 + below(chance(4) ? 20 : 400);
+
+      block.frames.resize(length);
+      for (int i = 0; i < length; i++)
+      {
+         Frame &frame = block.frames[i];
+         if (--clock_left <= 0)
+         {
+            clock_high = !clock_high;
+            clock_left = std::max(1, clock_period / 2 + below(3) - 1);
+         }
+         frame.clock = gate(clock_high);
+
+         if (block.write)
+         {
+            bool settled = i >= SETTLE;
+            if (settled && chance(50))
+               set_cv = gate(set_cv < 5.f);
+            if (settled && chance(50))
+               clear_cv = gate(clear_cv < 5.f);
+            frame.set = settled ? set_cv : 0.f;
+            frame.clear = settled ? clear_cv : 0.f;
+            frame.dir = dir_cv;
+         }
+         else
+         {
+            if (chance(300))
+               shift_cv = uniform(-2.f, 12.f);
+            if (chance(200))
+               dir_cv = gate(dir_cv < 1.f);
+            frame.set = 0.f;
+            frame.clear = 0.f;
+            frame.dir = dir_cv;
+         }
+         frame.shift = shift_cv;
+      }
+      return block;
+   }
+
+   // long enough for two param reads, so shift and direction are back at 1 bit left-to-right
+   static constexpr int SETTLE = 140;
+};
+
+// runs one block through a module, recording the compared outputs. returns the time spent in process().
+template <class TModule>
+double run(TModule &module, const Block &block, int64_t &frame, std::vector<float> &out)
+{
+   module.params[TModule::PROBABILITY_PARAM].setValue(block.prob);
+   module.params[TModule::SHIFT_PARAM].setValue(block.shift_param);
+   module.params[TModule::DIR_PARAM].setValue(block.dir_param);
+   module.params[TModule::SET_PARAM].setValue(block.write ? 0.f : block.set_param);
+   module.params[TModule::CLEAR_PARAM].setValue(block.write ? 0.f : block.clear_param);
+   module.inputs[TModule::CLOCK_INPUT].setChannels(1);
+   module.inputs[TModule::SHIFT_INPUT].setChannels(block.shift_connected);
+   module.inputs[TModule::DIR_INPUT].setChannels(block.dir_connected);
+   module.bit_pulse_mode = block.bit_pulse_mode;
+   module.random_pulse_mode = block.random_pulse_mode;
+
+   typename TModule::ProcessArgs args;
+   out.resize(block.frames.size() * RECORDED);
+   auto start = std::chrono::steady_clock::now();
+   for (size_t i = 0; i < block.frames.size(); i++)
+   {
+      const Frame &in = block.frames[i];
+      // the set and clear buttons are held down from the end of the settle period, like the gates
+      if (block.write && i == (size_t)Generator::SETTLE)
+      {
+         module.params[TModule::SET_PARAM].setValue(block.set_param);
+         module.params[TModule::CLEAR_PARAM].setValue(block.clear_param);
+      }
+      module.inputs[TModule::CLOCK_INPUT].setVoltage(in.clock);
+      module.inputs[TModule::SHIFT_INPUT].setVoltage(in.shift);
+      module.inputs[TModule::DIR_INPUT].setVoltage(in.dir);
+      module.inputs[TModule::SET_INPUT].setVoltage(in.set);
+      module.inputs[TModule::CLEAR_INPUT].setVoltage(in.clear);
+      args.frame = frame + i;
+      module.process(args);
+
+      float *o = &out[i * RECORDED];
+      for (int k = 0; k < COMPARED_COUNT; k++)
+      {
+         o[k] = module.outputs[COMPARED[k]].getVoltage();
+      }
+      if constexpr (std::is_same_v<TModule, Current>)
+         o[COMPARED_COUNT] = module.outputs[Current::CLOCK_OUTPUT].getVoltage();
+      else
+         o[COMPARED_COUNT] = in.clock;
+   }
+   auto end = std::chrono::steady_clock::now();
+   frame += block.frames.size();
+   return std::chrono::duration<double>(end - start).count();
+}
+
+int main(int argc, char **argv)
+{
+   int seeds = argc > 1 ? std::atoi(argv[1]) : 8;
+   int64_t samples = argc > 2 ? std::atoll(argv[2]) : 1000000;
+
+   double baseline_seconds = 0.0;
+   double current_seconds = 0.0;
+   int64_t total = 0;
+   int64_t edges = 0;
+   int64_t write_blocks = 0;
+   int mismatches = 0;
+   std::vector<float> baseline_out;
+   std::vector<float> current_out;
+
+   for (int seed = 1; seed <= seeds && mismatches == 0; seed++)
+   {
+      Generator gen(seed);
+      random::state() = 0x9e3779b97f4a7c15ull * seed;
+      std::unique_ptr<Baseline> reference(new Baseline);
+      std::unique_ptr<Current> current(new Current);
+      int64_t baseline_frame = 0;
+      int64_t current_frame = 0;
+      int block_index = 0;
+
+      for (int64_t done = 0; done < samples && mismatches == 0; block_index++)
+      {
+         Block block = gen.next(64 + gen.below(4000));
+         write_blocks += block.write;
+
+         uint64_t rng_start = random::state();
+         baseline_seconds += run(*reference, block, baseline_frame, baseline_out);
+         uint64_t rng_baseline = random::state();
+         random::state() = rng_start;
+         current_seconds += run(*current, block, current_frame, current_out);
+         if (random::state() != rng_baseline)
+         {
+            std::printf("seed %d block %d: random draws differ\n", seed, block_index);
+            mismatches++;
+         }
+
+         for (size_t i = 0; i < block.frames.size() && mismatches < 10; i++)
+         {
+            if (i > 0 && block.frames[i].clock >= 1.f && block.frames[i - 1].clock <= 0.f)
+               edges++;
+            for (int k = 0; k < RECORDED; k++)
+            {
+               float expected = baseline_out[i * RECORDED + k];
+               float actual = current_out[i * RECORDED + k];
+               if (std::memcmp(&expected, &actual, sizeof(float)) != 0)
+               {
+                  std::printf("seed %d block %d (%s) sample %zu: %s baseline %.9g current %.9g\n",
+                              seed, block_index, block.write ? "write" : "shift", i, outputName(k).c_str(), expected, actual);
+                  mismatches++;
+               }
+            }
+         }
+         done += block.frames.size();
+         total += block.frames.size();
+      }
+   }
+
+   std::printf("%lld samples, ~%lld clock edges, %lld write blocks\n", (long long)total, (long long)edges, (long long)write_blocks);
+   std::printf("baseline %.1f Msamples/s, current %.1f Msamples/s\n", total / baseline_seconds * 1e-6, total / current_seconds * 1e-6);
+   if (mismatches)
+   {
+      std::printf("FAILED: %d mismatch(es)\n", mismatches);
+      return 1;
+   }
+   std::printf("OK\n");
+   return 0;
+}
@@ -0,0 +1,727 @@
+/*
+ * Description:
+ * rack Stand-in for the parts of the VCV Rack 2 API the plugin uses, so its modules build and run without the SDK.
+ *
+ * The engine side behaves like Rack's: config* calls set params to their defaults, param
+ * quantities are bound to their param, ports carry voltages and channel counts, and the Schmitt
+ * trigger and pulse generator follow Rack's semantics. Random numbers come from one xorshift
+ * state behind random::state(), which a test can save and restore to feed several modules the
+ * same stream. The UI side (widgets, menus, svgs, json) only has to compile and does nothing.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include <emmintrin.h>
+#include <xmmintrin.h>
+
+#define ENUMS(name, count) name, name##_LAST = name + (count)-1
+#define RACK_GRID_WIDTH 15
+#define RACK_GRID_HEIGHT 380
+#define GLFW_PRESS 1
+#define GLFW_KEY_ENTER 257
+#define GLFW_KEY_KP_ENTER 335
+#define INFO(...) std::printf(__VA_ARGS__)
+#define WARN(...) std::printf(__VA_ARGS__)
+#define DEBUG(...) std::printf(__VA_ARGS__)
+
+// json: nothing is stored, every lookup misses
+struct json_t
+{
+    int type;
+};
+enum
+{
+    JSON_OBJECT,
+    JSON_ARRAY,
+    JSON_STRING,
+    JSON_INTEGER,
+    JSON_REAL,
+    JSON_TRUE,
+    JSON_FALSE,
+    JSON_NULL
+};
+inline json_t *json_object() { return nullptr; }
+inline json_t *json_array() { return nullptr; }
+inline int json_object_set_new(json_t *, const char *, json_t *) { return 0; }
+inline json_t *json_object_get(const json_t *, const char *) { return nullptr; }
+inline int json_object_del(json_t *, const char *) { return -1; }
+inline int json_array_append_new(json_t *, json_t *) { return 0; }
+inline json_t *json_array_get(const json_t *, size_t) { return nullptr; }
+inline size_t json_array_size(const json_t *) { return 0; }
+inline void json_decref(json_t *) {}
+inline json_t *json_integer(long long) { return nullptr; }
+inline json_t *json_real(double) { return nullptr; }
+inline json_t *json_string(const char *) { return nullptr; }
+inline json_t *json_boolean(bool) { return nullptr; }
+inline long long json_integer_value(const json_t *) { return 0; }
+inline double json_real_value(const json_t *) { return 0.0; }
+inline double json_number_value(const json_t *) { return 0.0; }
+inline const char *json_string_value(const json_t *) { return nullptr; }
+inline bool json_is_true(const json_t *) { return false; }
+inline bool json_boolean_value(const json_t *) { return false; }
+inline int json_typeof(const json_t *json) { return json ? json->type : JSON_NULL; }
+
+namespace rack
+{
+    template <typename T>
+    T clamp(T x, T a, T b) { return std::max(std::min(x, b), a); }
+    inline int clamp(int x, int a, int b) { return std::max(std::min(x, b), a); }
+    inline float clamp(float x, float a, float b) { return std::max(std::min(x, b), a); }
+
+    namespace string
+    {
+        inline std::string f(const char *format, ...)
+        {
+            char buffer[256];
+            va_list args;
+            va_start(args, format);
+            vsnprintf(buffer, sizeof buffer, format, args);
+            va_end(args);
+            return buffer;
+        }
+        inline std::string filename(const std::string &path) { return path; }
+        inline std::wstring UTF8toUTF16(const std::string &s) { return std::wstring(s.begin(), s.end()); }
+    }
+
+    namespace system
+    {
+        inline std::string getFilename(const std::string &path) { return path; }
+        inline bool exists(const std::string &) { return false; }
+    }
+
+    namespace math
+    {
+        struct Vec
+        {
+            float x = 0.f;
+            float y = 0.f;
+            Vec() {}
+            Vec(float x, float y) : x(x), y(y) {}
+            Vec plus(Vec b) const { return Vec(x + b.x, y + b.y); }
+            Vec mult(float s) const { return Vec(x * s, y * s); }
+        };
+        struct Rect
+        {
+            Vec pos;
+            Vec size;
+        };
+    }
+    using math::Rect;
+    using math::Vec;
+
+    namespace simd
+    {
+        struct float_4
+        {
+            __m128 v;
+            float_4() : v(_mm_setzero_ps()) {}
+            float_4(float x) : v(_mm_set1_ps(x)) {}
+            float_4(__m128 v) : v(v) {}
+            float_4(float a, float b, float c, float d) : v(_mm_setr_ps(a, b, c, d)) {}
+            static float_4 zero() { return float_4(); }
+            static float_4 load(const float *p) { return float_4(_mm_loadu_ps(p)); }
+            void store(float *p) const { _mm_storeu_ps(p, v); }
+            float &operator[](int i) { return ((float *)&v)[i]; }
+            const float &operator[](int i) const { return ((const float *)&v)[i]; }
+        };
+        inline float_4 operator+(float_4 a, float_4 b) { return _mm_add_ps(a.v, b.v); }
+        inline float_4 operator-(float_4 a, float_4 b) { return _mm_sub_ps(a.v, b.v); }
+        inline float_4 operator*(float_4 a, float_4 b) { return _mm_mul_ps(a.v, b.v); }
+        inline float_4 operator/(float_4 a, float_4 b) { return _mm_div_ps(a.v, b.v); }
+        inline float_4 operator>=(float_4 a, float_4 b) { return _mm_cmpge_ps(a.v, b.v); }
+        inline float_4 operator<(float_4 a, float_4 b) { return _mm_cmplt_ps(a.v, b.v); }
+        inline float_4 operator>(float_4 a, float_4 b) { return _mm_cmpgt_ps(a.v, b.v); }
+        inline float_4 operator<=(float_4 a, float_4 b) { return _mm_cmple_ps(a.v, b.v); }
+        inline float_4 operator&(float_4 a, float_4 b) { return _mm_and_ps(a.v, b.v); }
+        inline float_4 operator|(float_4 a, float_4 b) { return _mm_or_ps(a.v, b.v); }
+        inline float_4 operator~(float_4 a) { return _mm_xor_ps(a.v, _mm_castsi128_ps(_mm_set1_epi32(-1))); }
+        inline float_4 mask() { return _mm_castsi128_ps(_mm_set1_epi32(-1)); }
+        inline float_4 &operator+=(float_4 &a, float_4 b) { return a = a + b; }
+        inline float_4 &operator*=(float_4 &a, float_4 b) { return a = a * b; }
+        inline int movemask(float_4 a) { return _mm_movemask_ps(a.v); }
+        inline float_4 ifelse(float_4 m, float_4 a, float_4 b) { return _mm_or_ps(_mm_and_ps(m.v, a.v), _mm_andnot_ps(m.v, b.v)); }
+        inline float_4 clamp(float_4 x, float_4 a, float_4 b) { return _mm_max_ps(_mm_min_ps(x.v, b.v), a.v); }
+    }
+
+    namespace random
+    {
+        /// The whole generator state. Save and restore it to replay the same stream.
+        inline uint64_t &state()
+        {
+            static uint64_t x = 88172645463325252ull;
+            return x;
+        }
+        inline uint64_t u64()
+        {
+            uint64_t &x = state();
+            x ^= x << 13;
+            x ^= x >> 7;
+            x ^= x << 17;
+            return x;
+        }
+        inline uint32_t u32() { return (uint32_t)(u64() >> 32); }
+        inline float uniform() { return (u32() >> 8) * (1.f / (1 << 24)); }
+    }
+
+    namespace dsp
+    {
+        /// Lane-wise Schmitt trigger. Lanes start high and return all bits set on a rising edge.
+        template <typename T>
+        struct TSchmittTrigger
+        {
+            T state = simd::mask();
+            void reset() { state = simd::mask(); }
+            T process(T in, T low = 0.f, T high = 1.f)
+            {
+                T on = in >= high;
+                T off = in <= low;
+                T triggered = ~state & on;
+                state = on | (state & ~off);
+                return triggered;
+            }
+        };
+
+        template <>
+        struct TSchmittTrigger<float>
+        {
+            bool state = true;
+            void reset() { state = true; }
+            bool process(float in, float low = 0.f, float high = 1.f)
+            {
+                if (state)
+                {
+                    if (in <= low)
+                        state = false;
+                }
+                else if (in >= high)
+                {
+                    state = true;
+                    return true;
+                }
+                return false;
+            }
+            bool isHigh() { return state; }
+        };
+        typedef TSchmittTrigger<float> SchmittTrigger;
+        struct BooleanTrigger
+        {
+            bool state = true;
+            void reset() { state = true; }
+            bool process(bool in)
+            {
+                bool triggered = in && !state;
+                state = in;
+                return triggered;
+            }
+        };
+        struct PulseGenerator
+        {
+            float remaining = 0.f;
+            void reset() { remaining = 0.f; }
+            bool process(float deltaTime)
+            {
+                if (remaining > 0.f)
+                {
+                    remaining -= deltaTime;
+                    return true;
+                }
+                return false;
+            }
+            void trigger(float duration = 1e-3f)
+            {
+                if (duration > remaining)
+                    remaining = duration;
+            }
+        };
+    }
+
+    struct Quantity
+    {
+        virtual ~Quantity() {}
+        virtual void setValue(float) {}
+        virtual float getValue() { return 0.f; }
+        virtual float getMinValue() { return 0.f; }
+        virtual float getMaxValue() { return 1.f; }
+        virtual float getDefaultValue() { return 0.f; }
+        virtual float getDisplayValue() { return getValue(); }
+        virtual void setDisplayValue(float value) { setValue(value); }
+        virtual std::string getDisplayValueString() { return ""; }
+        virtual void setDisplayValueString(std::string) {}
+        virtual std::string getLabel() { return ""; }
+        virtual std::string getUnit() { return ""; }
+        virtual int getDisplayPrecision() { return 5; }
+    };
+
+    namespace engine
+    {
+        struct Module;
+
+        struct Param
+        {
+            float value = 0.f;
+            float getValue() { return value; }
+            void setValue(float v) { value = v; }
+        };
+
+        struct Port
+        {
+            float voltages[16] = {};
+            uint8_t channels = 0;
+            float getVoltage(int c = 0) { return voltages[c]; }
+            void setVoltage(float v, int c = 0) { voltages[c] = v; }
+            float getPolyVoltage(int c) { return voltages[c]; }
+            float getNormalVoltage(float normal, int c = 0) { return isConnected() ? voltages[c] : normal; }
+            simd::float_4 getVoltageSimd4(int c) { return simd::float_4::load(&voltages[c]); }
+            void setVoltageSimd(simd::float_4 v, int c) { v.store(&voltages[c]); }
+            bool isConnected() { return channels > 0; }
+            int getChannels() { return channels; }
+            void setChannels(int c) { channels = c; }
+        };
+        struct Input : Port
+        {
+        };
+        struct Output : Port
+        {
+        };
+
+        struct Light
+        {
+            float value = 0.f;
+            void setBrightness(float brightness) { value = brightness; }
+            void setBrightnessSmooth(float brightness, float) { value = brightness; }
+            float getBrightness() { return value; }
+        };
+
+        struct PortInfo
+        {
+            std::string name;
+            std::string description;
+        };
+
+        struct ParamQuantity : Quantity
+        {
+            Module *module = nullptr;
+            int paramId = 0;
+            std::string name;
+            std::string unit;
+            std::string description;
+            bool snapEnabled = false;
+            bool randomizeEnabled = true;
+            float minValue = 0.f;
+            float maxValue = 1.f;
+            float defaultValue = 0.f;
+            float displayBase = 0.f;
+            float displayMultiplier = 1.f;
+            float displayOffset = 0.f;
+            void setValue(float value) override;
+            float getValue() override;
+            float getMinValue() override { return minValue; }
+            float getMaxValue() override { return maxValue; }
+            float getDefaultValue() override { return defaultValue; }
+            virtual std::string getString() { return ""; }
+        };
+        struct SwitchQuantity : ParamQuantity
+        {
+            std::vector<std::string> labels;
+        };
+
+        struct Module
+        {
+            int64_t id = 0;
+            std::vector<Param> params;
+            std::vector<Input> inputs;
+            std::vector<Output> outputs;
+            std::vector<Light> lights;
+            std::vector<std::unique_ptr<ParamQuantity>> paramQuantities;
+            std::vector<PortInfo> inputInfos;
+            std::vector<PortInfo> outputInfos;
+
+            struct ProcessArgs
+            {
+                float sampleRate = 48000.f;
+                float sampleTime = 1.f / 48000.f;
+                int64_t frame = 0;
+            };
+
+            virtual ~Module() {}
+
+            void config(int numParams, int numInputs, int numOutputs, int numLights = 0)
+            {
+                params.resize(numParams);
+                inputs.resize(numInputs);
+                outputs.resize(numOutputs);
+                lights.resize(numLights);
+                paramQuantities.resize(numParams);
+                inputInfos.resize(numInputs);
+                outputInfos.resize(numOutputs);
+            }
+
+            template <class TParamQuantity = ParamQuantity>
+            TParamQuantity *configParam(int paramId, float minValue, float maxValue, float defaultValue, std::string name = "", std::string unit = "", float displayBase = 0.f, float displayMultiplier = 1.f, float displayOffset = 0.f)
+            {
+                TParamQuantity *q = new TParamQuantity;
+                q->module = this;
+                q->paramId = paramId;
+                q->minValue = minValue;
+                q->maxValue = maxValue;
+                q->defaultValue = defaultValue;
+                q->name = name;
+                q->unit = unit;
+                q->displayBase = displayBase;
+                q->displayMultiplier = displayMultiplier;
+                q->displayOffset = displayOffset;
+                paramQuantities[paramId].reset(q);
+                params[paramId].setValue(defaultValue);
+                return q;
+            }
+            template <class TSwitchQuantity = SwitchQuantity>
+            TSwitchQuantity *configSwitch(int paramId, float minValue, float maxValue, float defaultValue, std::string name = "", std::vector<std::string> labels = {})
+            {
+                TSwitchQuantity *q = configParam<TSwitchQuantity>(paramId, minValue, maxValue, defaultValue, name);
+                q->snapEnabled = true;
+                q->labels = labels;
+                return q;
+            }
+            template <class TSwitchQuantity = SwitchQuantity>
+            TSwitchQuantity *configButton(int paramId, std::string name = "")
+            {
+                return configSwitch<TSwitchQuantity>(paramId, 0.f, 1.f, 0.f, name);
+            }
+            PortInfo *configInput(int portId, std::string name = "")
+            {
+                inputInfos[portId].name = name;
+                return &inputInfos[portId];
+            }
+            PortInfo *configOutput(int portId, std::string name = "")
+            {
+                outputInfos[portId].name = name;
+                return &outputInfos[portId];
+            }
+            void configBypass(int, int) {}
+
+            ParamQuantity *getParamQuantity(int paramId) { return paramQuantities[paramId].get(); }
+            PortInfo *getInputInfo(int portId) { return &inputInfos[portId]; }
+            PortInfo *getOutputInfo(int portId) { return &outputInfos[portId]; }
+
+            virtual void process(const ProcessArgs &) {}
+            virtual void onReset() {}
+            virtual json_t *dataToJson() { return nullptr; }
+            virtual void dataFromJson(json_t *) {}
+        };
+
+        inline void ParamQuantity::setValue(float value) { module->params[paramId].setValue(clamp(value, minValue, maxValue)); }
+        inline float ParamQuantity::getValue() { return module->params[paramId].getValue(); }
+    }
+    using engine::Input;
+    using engine::Module;
+    using engine::Output;
+    using engine::ParamQuantity;
+    using engine::PortInfo;
+    using engine::SwitchQuantity;
+
+    namespace window
+    {
+        struct Svg
+        {
+            static std::shared_ptr<Svg> load(const std::string &) { return std::make_shared<Svg>(); }
+        };
+        struct Window
+        {
+            std::shared_ptr<Svg> loadSvg(const std::string &path) { return Svg::load(path); }
+        };
+    }
+    using window::Svg;
+
+    namespace event
+    {
+        struct Base
+        {
+            void consume(void *) {}
+            bool isConsumed() const { return false; }
+            void *getTarget() const { return nullptr; }
+        };
+        struct Hover : Base
+        {
+        };
+        struct SelectKey : Base
+        {
+            int key = 0;
+            int action = 0;
+            int mods = 0;
+        };
+        struct DragEnd : Base
+        {
+        };
+        struct Action : Base
+        {
+        };
+        struct Change : Base
+        {
+        };
+    }
+
+    // widgets are never drawn. children handed to a widget are deleted straight away.
+    namespace widget
+    {
+        struct Widget
+        {
+            Rect box;
+            Widget *parent = nullptr;
+            bool visible = true;
+            virtual ~Widget() {}
+            void addChild(Widget *child) { delete child; }
+            virtual void step() {}
+            virtual void onHover(const event::Hover &) {}
+            virtual void onSelectKey(const event::SelectKey &) {}
+            virtual void onDragEnd(const event::DragEnd &) {}
+            virtual void onAction(const event::Action &) {}
+            virtual void onChange(const event::Change &) {}
+            using HoverEvent = event::Hover;
+            using SelectKeyEvent = event::SelectKey;
+            using DragEndEvent = event::DragEnd;
+            using ActionEvent = event::Action;
+            using ChangeEvent = event::Change;
+        };
+        struct TransparentWidget : Widget
+        {
+        };
+        struct SvgWidget : Widget
+        {
+            void setSvg(std::shared_ptr<Svg>) {}
+        };
+        struct FramebufferWidget : Widget
+        {
+            void setDirty(bool = true) {}
+        };
+    }
+    using widget::Widget;
+
+    namespace ui
+    {
+        struct Menu : widget::Widget
+        {
+        };
+        struct MenuEntry : widget::Widget
+        {
+        };
+        struct MenuSeparator : MenuEntry
+        {
+        };
+        struct MenuLabel : MenuEntry
+        {
+            std::string text;
+        };
+        struct MenuItem : MenuEntry
+        {
+            std::string text;
+            std::string rightText;
+            bool disabled = false;
+            virtual Menu *createChildMenu() { return nullptr; }
+        };
+        struct TextField : widget::Widget
+        {
+            std::string text;
+            std::string placeholder;
+            void setText(std::string t) { text = t; }
+            std::string getText() { return text; }
+            void selectAll() {}
+        };
+        struct Slider : widget::Widget
+        {
+            Quantity *quantity = nullptr;
+        };
+    }
+    using ui::Menu;
+    using ui::MenuItem;
+    using ui::MenuLabel;
+    using ui::MenuSeparator;
+
+    namespace app
+    {
+        struct ParamWidget : widget::Widget
+        {
+            engine::Module *module = nullptr;
+            int paramId = 0;
+            ParamQuantity *getParamQuantity() { return module ? module->getParamQuantity(paramId) : nullptr; }
+        };
+        struct SvgKnob : ParamWidget
+        {
+            void setSvg(std::shared_ptr<Svg>) {}
+        };
+        struct SvgSlider : ParamWidget
+        {
+        };
+        struct CircularShadow : widget::Widget
+        {
+            float opacity = 1.f;
+        };
+        struct RoundKnob : SvgKnob
+        {
+            std::unique_ptr<widget::SvgWidget> background{new widget::SvgWidget};
+            widget::SvgWidget *bg = background.get();
+        };
+        struct RoundBlackKnob : RoundKnob
+        {
+        };
+        struct RoundLargeBlackKnob : RoundKnob
+        {
+        };
+        struct RoundSmallBlackKnob : RoundKnob
+        {
+        };
+        struct Trimpot : SvgKnob
+        {
+        };
+        struct PortWidget : widget::Widget
+        {
+            engine::Module *module = nullptr;
+            int portId = 0;
+            void destroyTooltip() {}
+        };
+        struct SvgPort : PortWidget
+        {
+            std::unique_ptr<CircularShadow> portShadow{new CircularShadow};
+            CircularShadow *shadow = portShadow.get();
+            void setSvg(std::shared_ptr<Svg>) {}
+        };
+        struct PJ301MPort : SvgPort
+        {
+        };
+        struct SvgSwitch : ParamWidget
+        {
+            void addFrame(std::shared_ptr<Svg>) {}
+        };
+        struct CKSS : SvgSwitch
+        {
+        };
+        struct LEDButton : SvgSwitch
+        {
+        };
+        struct VCVButton : SvgSwitch
+        {
+        };
+        struct ModuleLightWidget : widget::Widget
+        {
+        };
+        template <typename T>
+        struct MediumLight : T
+        {
+        };
+        template <typename T>
+        struct SmallLight : T
+        {
+        };
+        struct GreenLight : ModuleLightWidget
+        {
+        };
+        struct BlueLight : ModuleLightWidget
+        {
+        };
+        struct RedLight : ModuleLightWidget
+        {
+        };
+        struct YellowLight : ModuleLightWidget
+        {
+        };
+        struct ModuleWidget : widget::Widget
+        {
+            engine::Module *module = nullptr;
+            void setModule(engine::Module *m) { module = m; }
+            void setPanel(widget::Widget *panel) { delete panel; }
+            void addParam(ParamWidget *param) { delete param; }
+            void addInput(PortWidget *input) { delete input; }
+            void addOutput(PortWidget *output) { delete output; }
+            virtual void appendContextMenu(Menu *) {}
+        };
+        struct Scene
+        {
+            widget::Widget *rack = nullptr;
+        };
+    }
+    using namespace app;
+
+    namespace plugin
+    {
+        struct Model
+        {
+            std::string slug;
+        };
+        struct Plugin
+        {
+            void addModel(Model *) {}
+        };
+    }
+    using plugin::Model;
+    using plugin::Plugin;
+
+    namespace asset
+    {
+        inline std::string plugin(Plugin *, const std::string &path) { return path; }
+        inline std::string user(const std::string &path) { return path; }
+    }
+
+    struct Context
+    {
+        window::Window *window = nullptr;
+        app::Scene *scene = nullptr;
+    };
+    inline Context *contextGet()
+    {
+        static window::Window window;
+        static Context context{&window};
+        return &context;
+    }
+#define APP rack::contextGet()
+
+    template <class TModule, class TModuleWidget>
+    Model *createModel(std::string slug)
+    {
+        Model *model = new Model;
+        model->slug = slug;
+        return model;
+    }
+    template <class T>
+    T *createWidget(Vec) { return new T; }
+    template <class T>
+    T *createWidgetCentered(Vec) { return new T; }
+    inline widget::Widget *createPanel(std::string) { return new widget::Widget; }
+    template <class T>
+    T *createParam(Vec, engine::Module *module, int paramId)
+    {
+        T *param = new T;
+        param->module = module;
+        param->paramId = paramId;
+        return param;
+    }
+    template <class T>
+    T *createParamCentered(Vec pos, engine::Module *module, int paramId) { return createParam<T>(pos, module, paramId); }
+    template <class T>
+    T *createInputCentered(Vec, engine::Module *, int) { return new T; }
+    template <class T>
+    T *createOutputCentered(Vec, engine::Module *, int) { return new T; }
+    template <class T>
+    T *createLightCentered(Vec, engine::Module *, int) { return new T; }
+    template <class T = MenuLabel>
+    T *createMenuLabel(std::string) { return new T; }
+    template <class T = MenuItem>
+    T *createMenuItem(std::string, std::string = "", std::function<void()> = nullptr, bool = false, bool = false) { return new T; }
+    inline MenuItem *createCheckMenuItem(std::string, std::string, std::function<bool()>, std::function<void()>, bool = false, bool = false) { return new MenuItem; }
+    inline MenuItem *createBoolMenuItem(std::string, std::string, std::function<bool()>, std::function<void(bool)>, bool = false, bool = false) { return new MenuItem; }
+    template <typename T>
+    MenuItem *createBoolPtrMenuItem(std::string, std::string, T *) { return new MenuItem; }
+    inline MenuItem *createSubmenuItem(std::string, std::string, std::function<void(Menu *)>, bool = false) { return new MenuItem; }
+    inline MenuItem *createIndexSubmenuItem(std::string, std::vector<std::string>, std::function<size_t()>, std::function<void(size_t)>, bool = false, bool = false) { return new MenuItem; }
+    template <typename T>
+    MenuItem *createIndexPtrSubmenuItem(std::string, std::vector<std::string>, T *) { return new MenuItem; }
+}
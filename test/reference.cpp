@@ -0,0 +1,692 @@
+// Reference test of TapeMachineModule's clock edge work against a straightforward model of it.
+//
+// The model is written the obvious way: per-bit loops, rescans of the whole history, and a
+// tree-walking interpreter for the logic expressions. The module gets fuzzed clock, set, clear,
+// shift, direction, probability, write window, morph, pattern and write streams, with random logic
+// expressions, dac weights, modes and output cables. On every clock edge the model takes the
+// module's shift, direction, random flip, set and clear, works out the write window, the morph,
+// the pattern load and the written value from the inputs itself, and checks the tape, statistics,
+// dac and logic outputs. Dac and held or clocked logic outputs are checked on every sample.
+//
+// usage: reference [seeds] [samples per seed]
+
+#include "TapeMachine.cpp"
+#include <chrono>
+#include <deque>
+#include <random>
+
+Plugin *pluginInstance;
+
+namespace reference
+{
+static const int BITS = 16;
+
+bool bit(uint16_t tape, int i)
+{
+   return (tape >> i) & 1;
+}
+
+// index of the bit a new value enters at: the top bit when shifting left-to-right, bit 0 when right-to-left
+int head(bool rtl)
+{
+   return rtl ? 0 : BITS - 1;
+}
+
+// shifts one bit at a time, then flips the head. a negative shift (shift cv below 0V) moves the other way.
+uint16_t step(uint16_t tape, bool rtl, int shift, bool flip)
+{
+   bool left = rtl != (shift < 0);
+   for (int s = 0; s < std::abs(shift); s++)
+   {
+      if (left)
+         tape = (uint16_t)((tape << 1) | bit(tape, BITS - 1));
+      else
+         tape = (uint16_t)((tape >> 1) | (bit(tape, 0) << (BITS - 1)));
+   }
+   if (flip)
+      tape ^= 1 << head(rtl);
+   return tape;
+}
+
+// sets or clears `width` bits starting `position` bits in from the head
+uint16_t window(uint16_t tape, bool rtl, bool set, bool clear, int width, int position)
+{
+   for (int s = position; s < position + width; s++)
+   {
+      int i = rtl ? (head(rtl) + s) % BITS : (head(rtl) - s + 2 * BITS) % BITS;
+      if (clear)
+         tape &= ~(1 << i);
+      if (set)
+         tape |= 1 << i;
+   }
+   return tape;
+}
+
+// flips the first `round(amount * differing bits)` bits that differ from `target`, scanning up from bit 0
+uint16_t morph(uint16_t tape, uint16_t target, float amount)
+{
+   int differing = 0;
+   for (int i = 0; i < BITS; i++)
+      differing += bit(tape, i) != bit(target, i);
+   int steps = (int)std::round(clamp(amount, 0.f, 1.f) * differing);
+   for (int i = 0; i < BITS && steps > 0; i++)
+   {
+      if (bit(tape, i) != bit(target, i))
+      {
+         tape ^= 1 << i;
+         steps--;
+      }
+   }
+   return tape;
+}
+
+int density(uint16_t tape)
+{
+   int n = 0;
+   for (int i = 0; i < BITS; i++)
+      n += bit(tape, i);
+   return n;
+}
+
+int longestRun(uint16_t tape)
+{
+   if (density(tape) == BITS)
+      return BITS;
+   // start scanning just after a clear bit, so no run is split by the end of the tape
+   int start = 0;
+   while (bit(tape, start))
+      start++;
+   int best = 0, run = 0;
+   for (int s = 1; s <= BITS; s++)
+   {
+      run = bit(tape, (start + s) % BITS) ? run + 1 : 0;
+      best = std::max(best, run);
+   }
+   return best;
+}
+
+int transitions(uint16_t tape)
+{
+   int n = 0;
+   for (int i = 0; i < BITS; i++)
+      n += bit(tape, i) != bit(tape, (i + 1) % BITS);
+   return n;
+}
+
+float entropy(const std::deque<uint16_t> &history, size_t window)
+{
+   int ones = 0;
+   for (uint16_t tape : history)
+      ones += density(tape);
+   float p = (float)ones / (window * BITS);
+   if (p <= 0.f || p >= 1.f)
+      return 0.f;
+   return -p * std::log2(p) - (1.f - p) * std::log2(1.f - p);
+}
+
+float dac(uint16_t tape, const float *weights)
+{
+   float sum = 0.f, total = 0.f;
+   for (int i = 0; i < BITS; i++)
+   {
+      sum += bit(tape, i) ? weights[i] : 0.f;
+      total += weights[i];
+   }
+   return total > 0.f ? sum / total : 0.f;
+}
+
+// evaluates a logic expression directly from its text. false for empty or invalid expressions.
+struct LogicInterpreter
+{
+   const char *p;
+   uint16_t tape;
+   bool ok = true;
+
+   static bool eval(const std::string &text, uint16_t tape)
+   {
+      LogicInterpreter in{text.c_str(), tape};
+      in.space();
+      if (!*in.p)
+         return false;
+      bool v = in.parseOr();
+      return in.ok && !*in.p && v;
+   }
+
+   void space()
+   {
+      while (*p == ' ' || *p == '\t')
+         p++;
+   }
+   bool accept(char c)
+   {
+      space();
+      if (*p != c)
+         return false;
+      p++;
+      space();
+      return true;
+   }
+   bool parseOr()
+   {
+      bool v = parseXor();
+      while (accept('|'))
+         v = parseXor() || v;
+      return v;
+   }
+   bool parseXor()
+   {
+      bool v = parseAnd();
+      while (accept('^'))
+         v = parseAnd() != v;
+      return v;
+   }
+   bool parseAnd()
+   {
+      bool v = parseUnary();
+      while (accept('&'))
+         v = parseUnary() && v;
+      return v;
+   }
+   bool parseUnary()
+   {
+      if (accept('!') || accept('~'))
+         return !parseUnary();
+      return parsePrimary();
+   }
+   bool parsePrimary()
+   {
+      space();
+      if (accept('('))
+      {
+         bool v = parseOr();
+         ok = ok && accept(')');
+         return v;
+      }
+      if (*p == '0' || *p == '1')
+      {
+         bool v = *p++ == '1';
+         space();
+         return v;
+      }
+      if (*p == 'b' || *p == 'B')
+      {
+         p++;
+         int i = 0, digits = 0;
+         while (*p >= '0' && *p <= '9')
+         {
+            i = i * 10 + (*p++ - '0');
+            digits++;
+         }
+         space();
+         ok = ok && digits > 0 && i < BITS;
+         return ok && bit(tape, i);
+      }
+      ok = false;
+      return false;
+   }
+};
+}
+
+using Machine = TapeMachineModule;
+
+// cv inputs the generator drives
+enum Cv
+{
+   SET,
+   CLEAR,
+   SHIFT,
+   DIR,
+   PROB,
+   WIDTH,
+   POS,
+   MORPH,
+   PATTERN,
+   LOAD,
+   GATE,
+   WRITE,
+   NUM_CV
+};
+static const int DRIVEN[NUM_CV] = {
+    Machine::SET_INPUT, Machine::CLEAR_INPUT, Machine::SHIFT_INPUT, Machine::DIR_INPUT, Machine::PROB_INPUT,
+    Machine::WINDOW_WIDTH_INPUT, Machine::WINDOW_POS_INPUT, Machine::MORPH_INPUT, Machine::PATTERN_INPUT,
+    Machine::PATTERN_LOAD_INPUT, Machine::WRITE_GATE_INPUT, Machine::WRITE_INPUT};
+
+// input voltages for one sample
+struct Frame
+{
+   float clock;
+   float cv[NUM_CV];
+};
+
+// outputs whose cables come and go between blocks: statistics, then dac, then logic
+static const int DAC_CABLE = 4;
+static const int LOGIC_CABLE = DAC_CABLE + WeightedDac::TAPS;
+static const int CABLED[] = {
+    Machine::DENSITY_OUTPUT, Machine::RUN_OUTPUT, Machine::TRANSITIONS_OUTPUT, Machine::ENTROPY_OUTPUT,
+    Machine::DAC_OUTPUT + 0, Machine::DAC_OUTPUT + 1, Machine::DAC_OUTPUT + 2, Machine::DAC_OUTPUT + 3,
+    Machine::LOGIC_OUTPUT + 0, Machine::LOGIC_OUTPUT + 1, Machine::LOGIC_OUTPUT + 2, Machine::LOGIC_OUTPUT + 3};
+
+// everything that stays fixed for a block
+struct Block
+{
+   float params[Machine::NUM_PARAMS];
+   bool connected[NUM_CV];
+   bool cabled[sizeof CABLED / sizeof CABLED[0]];
+   size_t bit_pulse_mode;
+   size_t pattern_bank;
+   bool write_gray;
+   uint16_t morph_snapshot;
+   bool sample_on_clock[Machine::NUM_SAMPLED];
+   // -1 for no change, otherwise the logic output given `expression`
+   int logic_index;
+   std::string expression;
+   // -1 for no change, otherwise the dac tap given new random weights
+   int dac_tap;
+   float weights[WeightedDac::BITS];
+   std::vector<Frame> frames;
+};
+
+struct Generator
+{
+   std::mt19937_64 rng;
+   // clock state carries over between blocks so edges are not only at block starts
+   int clock_left = 1;
+   bool clock_high = false;
+   float held[NUM_CV] = {};
+
+   explicit Generator(uint64_t seed) : rng(seed) {}
+
+   int below(int n)
+   {
+      return (int)(rng() % n);
+   }
+
+   float uniform(float a, float b)
+   {
+      return a + (b - a) * (rng() >> 40) * (1.f / (1 << 24));
+   }
+
+   bool chance(int one_in)
+   {
+      return below(one_in) == 0;
+   }
+
+   // valid most of the time, with the odd empty, out of range or unbalanced expression
+   std::string expression(int depth = 0)
+   {
+      switch (below(depth > 2 ? 3 : 9))
+      {
+      case 0:
+         return "b" + std::to_string(below(16));
+      case 1:
+         return "B" + std::to_string(below(16));
+      case 2:
+         return chance(2) ? "1" : "0";
+      case 3:
+         return "!" + expression(depth + 1);
+      case 4:
+         return "~ " + expression(depth + 1);
+      case 5:
+         return "(" + expression(depth + 1) + ")";
+      case 6:
+         return expression(depth + 1) + " & " + expression(depth + 1);
+      case 7:
+         return expression(depth + 1) + "|" + expression(depth + 1);
+      default:
+         return expression(depth + 1) + " ^ " + expression(depth + 1);
+      }
+   }
+
+   std::string anyExpression()
+   {
+      switch (below(12))
+      {
+      case 0:
+         return "";
+      case 1:
+         return "b16";
+      case 2:
+         return "(" + expression();
+      case 3:
+         return expression() + " &";
+      default:
+         return expression();
+      }
+   }
+
+   Block next(int length)
+   {
+      Block block = {};
+      float *p = block.params;
+      p[Machine::PROBABILITY_PARAM] = chance(6) ? (float)below(2) : uniform(0.f, 1.f);
+      p[Machine::PROB_CV_PARAM] = uniform(-1.f, 1.f);
+      p[Machine::SHIFT_PARAM] = 1 + below(15);
+      p[Machine::DIR_PARAM] = below(2);
+      p[Machine::SET_PARAM] = chance(6);
+      p[Machine::CLEAR_PARAM] = chance(6);
+      p[Machine::WINDOW_WIDTH_PARAM] = 1 + below(16);
+      p[Machine::WINDOW_POS_PARAM] = below(16);
+      p[Machine::MORPH_PARAM] = chance(3) ? 0.f : uniform(0.f, 1.f);
+      p[Machine::PATTERN_PARAM] = uniform(0.f, 1.f);
+      p[Machine::WRITE_PARAM] = chance(10);
+      for (int i = 0; i < NUM_CV; i++)
+      {
+         block.connected[i] = chance(2);
+      }
+      for (bool &cabled : block.cabled)
+      {
+         cabled = !chance(4);
+      }
+      block.bit_pulse_mode = below(3);
+      block.pattern_bank = below(PatternLibrary::NUM_BANKS);
+      block.write_gray = chance(2);
+      block.morph_snapshot = rng();
+      for (bool &sampled : block.sample_on_clock)
+      {
+         sampled = chance(2);
+      }
+      block.logic_index = chance(3) ? below(Machine::LOGIC_COUNT) : -1;
+      block.expression = anyExpression();
+      block.dac_tap = chance(3) ? below(WeightedDac::TAPS) : -1;
+      for (float &w : block.weights)
+      {
+         w = chance(4) ? 0.f : uniform(0.f, 1.f);
+      }
+      int clock_period = 2 + below(chance(4) ? 20 : 400);
+
+      block.frames.resize(length);
+      for (int i = 0; i < length; i++)
+      {
+         Frame &frame = block.frames[i];
+         if (--clock_left <= 0)
+         {
+            clock_high = !clock_high;
+            clock_left = std::max(1, clock_period / 2 + below(3) - 1);
+         }
+         frame.clock = clock_high ? 10.f : 0.f;
+
+         float *h = held;
+         if (chance(60))
+            h[SET] = h[SET] > 5.f ? 0.f : 10.f;
+         if (chance(60))
+            h[CLEAR] = h[CLEAR] > 5.f ? 0.f : 10.f;
+         if (chance(300))
+            h[SHIFT] = uniform(-2.f, 12.f);
+         if (chance(200))
+            h[DIR] = h[DIR] > 0.f ? 0.f : 10.f;
+         if (chance(200))
+            h[PROB] = uniform(-10.f, 10.f);
+         if (chance(200))
+            h[WIDTH] = uniform(-10.f, 10.f);
+         if (chance(200))
+            h[POS] = uniform(-12.f, 12.f);
+         if (chance(200))
+            h[MORPH] = uniform(-2.f, 10.f);
+         if (chance(200))
+            h[PATTERN] = uniform(-2.f, 12.f);
+         if (chance(400))
+            h[LOAD] = h[LOAD] > 0.f ? 0.f : 10.f;
+         if (chance(80))
+            h[GATE] = h[GATE] > 5.f ? 0.f : 10.f;
+         if (chance(40))
+            h[WRITE] = uniform(-11.f, 11.f);
+         // the load trigger ends each block low, so the trigger state never depends on whether it saw the unplugged input
+         if (i == length - 1)
+            h[LOAD] = 0.f;
+         std::copy(h, h + NUM_CV, frame.cv);
+      }
+      return block;
+   }
+};
+
+// the module's state that the model tracks between edges
+struct Expected
+{
+   uint16_t tape = 0;
+   std::deque<uint16_t> history;
+   uint16_t view = 0;
+   std::string expressions[Machine::LOGIC_COUNT];
+   bool logic[Machine::LOGIC_COUNT] = {};
+   float dac[WeightedDac::TAPS] = {};
+   dsp::SchmittTrigger clock;
+   dsp::SchmittTrigger load;
+   bool armed = false;
+};
+
+struct Counts
+{
+   int64_t samples = 0;
+   int64_t edges = 0;
+   int64_t loads = 0;
+   int64_t writes = 0;
+   int64_t windows = 0;
+   int64_t morphs = 0;
+   int64_t tape = 0;
+   int64_t stats = 0;
+   int64_t dac = 0;
+   int64_t logic = 0;
+
+   int64_t mismatches() const
+   {
+      return tape + stats + dac + logic;
+   }
+};
+
+static bool near(float a, float b)
+{
+   return std::abs(a - b) <= 1e-4f * std::max(1.f, std::abs(b));
+}
+
+static void updateDac(Machine &module, Expected &model)
+{
+   for (int t = 0; t < WeightedDac::TAPS; t++)
+   {
+      float weights[WeightedDac::BITS];
+      for (int i = 0; i < WeightedDac::BITS; i++)
+         weights[i] = module.dac.getWeight(t, i);
+      model.dac[t] = reference::dac(model.view, weights);
+   }
+}
+
+// what the module reads from a driven input: unplugged inputs read 0V
+static float cv(const Block &block, const Frame &in, Cv id)
+{
+   return block.connected[id] ? in.cv[id] : 0.f;
+}
+
+static void runBlock(Machine &module, Expected &model, const Block &block, int64_t &frame, Counts &counts, int seed, int block_index)
+{
+   for (int id = 0; id < Machine::NUM_PARAMS; id++)
+   {
+      if (id != Machine::MORPH_SNAP_PARAM && id != Machine::PATTERN_LOAD_PARAM)
+         module.params[id].setValue(block.params[id]);
+   }
+   module.inputs[Machine::CLOCK_INPUT].setChannels(1);
+   for (int i = 0; i < NUM_CV; i++)
+   {
+      module.inputs[DRIVEN[i]].setChannels(block.connected[i]);
+      module.inputs[DRIVEN[i]].setVoltage(0.f);
+   }
+   for (size_t i = 0; i < sizeof CABLED / sizeof CABLED[0]; i++)
+   {
+      module.outputs[CABLED[i]].setChannels(block.cabled[i]);
+   }
+   module.bit_pulse_mode = block.bit_pulse_mode;
+   module.pattern_bank = block.pattern_bank;
+   module.write_gray = block.write_gray;
+   module.morph_snapshot = block.morph_snapshot;
+   std::copy(block.sample_on_clock, block.sample_on_clock + Machine::NUM_SAMPLED, module.sample_on_clock);
+   if (block.logic_index >= 0)
+   {
+      module.setLogicExpression(block.logic_index, block.expression);
+      model.expressions[block.logic_index] = block.expression;
+   }
+   if (block.dac_tap >= 0)
+   {
+      for (int i = 0; i < WeightedDac::BITS; i++)
+         module.dac.setWeight(block.dac_tap, i, block.weights[i]);
+   }
+   updateDac(module, model);
+   // the dac outputs are first written, and pick up new weights, on the module's next clock or param read
+   bool dac_stale = block.dac_tap >= 0 || frame == 0;
+
+   const float *p = block.params;
+   Machine::ProcessArgs args;
+   for (size_t n = 0; n < block.frames.size(); n++)
+   {
+      const Frame &in = block.frames[n];
+      module.inputs[Machine::CLOCK_INPUT].setVoltage(in.clock);
+      for (int i = 0; i < NUM_CV; i++)
+      {
+         module.inputs[DRIVEN[i]].setVoltage(cv(block, in, (Cv)i));
+      }
+      args.frame = frame++;
+      module.process(args);
+      counts.samples++;
+
+      model.armed = model.load.process(cv(block, in, LOAD)) || model.armed;
+      bool edge = model.clock.process(in.clock);
+      if (edge || module.check_params == 0)
+         dac_stale = false;
+      auto report = [&](const char *what, float expected, float actual)
+      {
+         if (counts.mismatches() <= 10)
+            std::printf("seed %d block %d sample %zu: %s expected %.9g module %.9g\n", seed, block_index, n, what, expected, actual);
+      };
+
+      if (edge)
+      {
+         counts.edges++;
+         // shift, direction, random flip, set and clear are the module's decisions, replayed here
+         bool write = p[Machine::WRITE_PARAM] > 0.f || cv(block, in, GATE) > 5.f;
+         uint16_t tape = reference::step(model.tape, module.rtl, module.shift_amt, module.noise >= module.prob);
+         if (write)
+         {
+            float x = module.voltage_range.range > 0.f ? module.voltage_range.invMap(cv(block, in, WRITE)) : 0.f;
+            uint16_t value = (uint16_t)std::round(clamp(x, 0.f, 1.f) * 65535.f);
+            tape = block.write_gray ? value ^ (value >> 1) : value;
+            counts.writes++;
+         }
+         if (model.armed)
+         {
+            float position = p[Machine::PATTERN_PARAM] + cv(block, in, PATTERN) / 10.f;
+            tape = PatternLibrary::get(block.pattern_bank, PatternLibrary::index(block.pattern_bank, position));
+            model.armed = false;
+            counts.loads++;
+         }
+         if (module.set || module.clear)
+         {
+            int width = clamp((int)p[Machine::WINDOW_WIDTH_PARAM] + (int)std::round(cv(block, in, WIDTH) / 10.f * 16.f), 1, 16);
+            int position = (((int)p[Machine::WINDOW_POS_PARAM] + (int)std::round(cv(block, in, POS) / 10.f * 16.f)) % 16 + 16) % 16;
+            tape = reference::window(tape, module.rtl, module.set, module.clear, width, position);
+            counts.windows++;
+         }
+         if (tape != module.tape)
+         {
+            report("tape", tape, module.tape);
+            counts.tape++;
+            // keep comparing from the module's state, so one divergence is not counted on every later edge
+            tape = module.tape;
+         }
+         model.tape = tape;
+
+         // statistics, dac and logic read the morphed tape, like the module's outputs
+         float amount = clamp(p[Machine::MORPH_PARAM] + cv(block, in, MORPH) / 10.f, 0.f, 1.f);
+         model.view = reference::morph(tape, block.morph_snapshot, amount);
+         counts.morphs += model.view != tape;
+         model.history.push_back(model.view);
+         if (model.history.size() > TapeStats::HISTORY)
+            model.history.pop_front();
+
+         float stats[] = {reference::density(model.view) / 1.6f, reference::longestRun(model.view) / 1.6f,
+                          reference::transitions(model.view) / 1.6f, reference::entropy(model.history, TapeStats::HISTORY) * 10.f};
+         static const char *stat_names[] = {"density", "run", "transitions", "entropy"};
+         for (int i = 0; i < 4; i++)
+         {
+            float actual = module.outputs[CABLED[i]].getVoltage();
+            if (block.cabled[i] && !near(actual, stats[i]))
+            {
+               report(stat_names[i], stats[i], actual);
+               counts.stats++;
+            }
+         }
+
+         updateDac(module, model);
+         // unconnected logic outputs keep their state from the last clock they were connected for
+         for (int i = 0; i < Machine::LOGIC_COUNT; i++)
+         {
+            if (!block.cabled[LOGIC_CABLE + i])
+               continue;
+            model.logic[i] = reference::LogicInterpreter::eval(model.expressions[i], model.view);
+            if (model.logic[i] != module.logic_state[i])
+            {
+               report("logic state", model.logic[i], module.logic_state[i]);
+               counts.logic++;
+            }
+         }
+      }
+
+      for (int t = 0; t < WeightedDac::TAPS; t++)
+      {
+         float expected = module.dac_ranges[t].map(model.dac[t]);
+         float actual = module.outputs[Machine::DAC_OUTPUT + t].getVoltage();
+         if (block.cabled[DAC_CABLE + t] && !dac_stale && !near(actual, expected))
+         {
+            report("dac", expected, actual);
+            counts.dac++;
+         }
+      }
+
+      // trigger mode pulses outlast the edge, so only the edge that fires one is checked
+      for (int i = 0; i < Machine::LOGIC_COUNT; i++)
+      {
+         if (!block.cabled[LOGIC_CABLE + i] || (block.bit_pulse_mode == 0 && !(edge && model.logic[i])))
+            continue;
+         float expected = !model.logic[i] ? 0.f : block.bit_pulse_mode == 1 ? in.clock : 10.f;
+         float actual = module.outputs[Machine::LOGIC_OUTPUT + i].getVoltage();
+         if (actual != expected)
+         {
+            report("logic output", expected, actual);
+            counts.logic++;
+         }
+      }
+   }
+}
+
+int main(int argc, char **argv)
+{
+   int seeds = argc > 1 ? std::atoi(argv[1]) : 8;
+   int64_t samples = argc > 2 ? std::atoll(argv[2]) : 1000000;
+
+   Counts counts;
+   double seconds = 0.0;
+   for (int seed = 1; seed <= seeds && counts.mismatches() == 0; seed++)
+   {
+      Generator gen(seed);
+      random::state() = 0x9e3779b97f4a7c15ull * seed;
+      std::unique_ptr<Machine> module(new Machine);
+      Expected model;
+      int64_t frame = 0;
+
+      for (int block_index = 0; frame < samples && counts.mismatches() == 0; block_index++)
+      {
+         Block block = gen.next(64 + gen.below(4000));
+         auto start = std::chrono::steady_clock::now();
+         runBlock(*module, model, block, frame, counts, seed, block_index);
+         seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+      }
+   }
+
+   std::printf("%lld samples, %lld clock edges: %lld pattern loads, %lld writes, %lld set/clear windows, %lld morphed\n",
+               (long long)counts.samples, (long long)counts.edges, (long long)counts.loads, (long long)counts.writes,
+               (long long)counts.windows, (long long)counts.morphs);
+   std::printf("module and model %.1f Msamples/s\n", counts.samples / seconds * 1e-6);
+   if (counts.mismatches())
+   {
+      std::printf("FAILED: tape %lld, stats %lld, dac %lld, logic %lld mismatch(es)\n",
+                  (long long)counts.tape, (long long)counts.stats, (long long)counts.dac, (long long)counts.logic);
+      return 1;
+   }
+   std::printf("OK\n");
+   return 0;
+}